@@ -0,0 +1,192 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file fault.c
+ * @brief Fault injection for soak testing.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fault.h"
+#include "log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define FAULT_ENV                   "MLC_FAULTS"
+#define FAULT_SEED_ENV              "MLC_FAULT_SEED"
+#define DEFAULT_SLOW_MS             (100)
+#define DEFAULT_IPC_BURST           (1)
+//! @endcond
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/** Names of faults in MLC_FAULTS, indexed by Fault. */
+static const char *g_faultNames[Fault_Max] = { "led_fail", "led_slow", "drop", "ipc", "deregister" };
+/** Probability of each fault per opportunity. */
+static double g_faultRates[Fault_Max];
+/** Number of times each fault was injected. */
+static unsigned long g_faultCounts[Fault_Max];
+/** Delay of a slow led write in milliseconds. */
+static unsigned int g_slowMs = DEFAULT_SLOW_MS;
+/** Number of process calls that fail in a row once an IPC fault is injected. */
+static unsigned int g_ipcBurst = DEFAULT_IPC_BURST;
+/** Process calls still to fail in the current IPC burst. */
+static unsigned int g_ipcBurstLeft;
+/** State of the random draws. */
+static unsigned int g_seed = 1;
+/** Guards lazy initialisation and the random state. */
+static pthread_mutex_t g_faultLock = PTHREAD_MUTEX_INITIALIZER;
+/** Set once MLC_FAULTS has been parsed. */
+static bool g_faultsParsed = false;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Parse MLC_FAULTS and MLC_FAULT_SEED. Called with g_faultLock held.
+ */
+static void ParseFaults(void)
+{
+    unsigned int i;
+    const char *env = getenv(FAULT_ENV);
+    const char *seed = getenv(FAULT_SEED_ENV);
+
+    if (seed != NULL)
+    {
+        g_seed = strtoul(seed, NULL, 0);
+    }
+
+    while (env != NULL && *env != '\0')
+    {
+        const char *separator = strchr(env, '=');
+        if (separator == NULL)
+        {
+            break;
+        }
+        size_t nameLength = separator - env;
+
+        if (nameLength == strlen("slow_ms") && !strncmp(env, "slow_ms", nameLength))
+        {
+            g_slowMs = strtoul(separator + 1, NULL, 0);
+        }
+        else if (nameLength == strlen("ipc_burst") && !strncmp(env, "ipc_burst", nameLength))
+        {
+            g_ipcBurst = strtoul(separator + 1, NULL, 0);
+            g_ipcBurst = g_ipcBurst ? g_ipcBurst : 1;
+        }
+        else
+        {
+            for (i = 0; i < Fault_Max; i++)
+            {
+                if (nameLength == strlen(g_faultNames[i]) && !strncmp(env, g_faultNames[i], nameLength))
+                {
+                    g_faultRates[i] = strtod(separator + 1, NULL);
+                    LOG(LOG_INFO, "Injecting %s faults at rate %g", g_faultNames[i], g_faultRates[i]);
+                    break;
+                }
+            }
+            if (i == Fault_Max)
+            {
+                LOG(LOG_WARN, "Unknown fault %.*s in " FAULT_ENV, (int)nameLength, env);
+            }
+        }
+
+        env = strchr(separator, ',');
+        if (env != NULL)
+        {
+            env++;
+        }
+    }
+    g_faultsParsed = true;
+}
+
+bool Fault_Inject(Fault fault)
+{
+    bool inject = false;
+
+    if (fault >= Fault_Max)
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&g_faultLock);
+    if (!g_faultsParsed)
+    {
+        ParseFaults();
+    }
+    if (fault == Fault_IPCError && g_ipcBurstLeft > 0)
+    {
+        g_ipcBurstLeft--;
+        g_faultCounts[fault]++;
+        inject = true;
+    }
+    else if (g_faultRates[fault] > 0 && rand_r(&g_seed) < g_faultRates[fault] * ((double)RAND_MAX + 1))
+    {
+        g_faultCounts[fault]++;
+        inject = true;
+        if (fault == Fault_IPCError)
+        {
+            g_ipcBurstLeft = g_ipcBurst - 1;
+        }
+    }
+    pthread_mutex_unlock(&g_faultLock);
+    return inject;
+}
+
+unsigned int Fault_SlowMs(void)
+{
+    return g_slowMs;
+}
+
+unsigned long Fault_Count(Fault fault)
+{
+    unsigned long count = 0;
+
+    if (fault < Fault_Max)
+    {
+        pthread_mutex_lock(&g_faultLock);
+        count = g_faultCounts[fault];
+        pthread_mutex_unlock(&g_faultLock);
+    }
+    return count;
+}
@@ -0,0 +1,85 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file fault.h
+ * @brief Fault injection for soak testing. Only compiled in with ENABLE_FAULT_INJECTION.
+ *
+ * Rates are read once from the MLC_FAULTS environment variable, a comma separated list of
+ * name=value pairs, e.g. "led_fail=0.01,led_slow=0.05,slow_ms=200,drop=0.01". Names are
+ * led_fail, led_slow, drop, ipc and deregister, each a probability between 0 and 1 per
+ * opportunity, slow_ms, the delay of a slow led write, and ipc_burst, the number of process
+ * calls that fail in a row from each injected IPC fault, 1 by default. MLC_FAULT_SEED seeds
+ * the draws.
+ */
+
+#ifndef FAULT_H
+#define FAULT_H
+
+#ifdef ENABLE_FAULT_INJECTION
+
+#include <stdbool.h>
+
+/**
+ * Faults that can be injected.
+ */
+typedef enum
+{
+    Fault_LedFail,              /**< led write fails */
+    Fault_LedSlow,              /**< led write is delayed by slow_ms */
+    Fault_DropNotification,     /**< notification is lost before delivery */
+    Fault_IPCError,             /**< server session process fails */
+    Fault_Deregister,           /**< constrained device drops off the server for a while */
+    Fault_Max
+} Fault;
+
+/**
+ * @brief Decide whether to inject a fault at this opportunity.
+ * @param fault fault to draw for.
+ * @return true if the fault should be injected, else false.
+ */
+bool Fault_Inject(Fault fault);
+
+/**
+ * @brief Get the delay of a slow led write.
+ * @return delay in milliseconds.
+ */
+unsigned int Fault_SlowMs(void);
+
+/**
+ * @brief Get the number of times a fault has been injected.
+ * @param fault fault to query.
+ * @return injection count.
+ */
+unsigned long Fault_Count(Fault fault);
+
+#endif
+
+#endif  /* FAULT_H */
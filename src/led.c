@@ -0,0 +1,144 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file led.c
+ * @brief Control of on board leds through the sysfs leds class.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "fault.h"
+#include "led.h"
+#include "log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define LED_NAME_FORMAT             "%s/marduk:red:user%u/%s"
+#define LED_PATH_SIZE               (128)
+#define LED_LEVEL_SIZE              (16)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Read max_brightness of a led, falling back to on/off when it cannot be read.
+ * @param *root sysfs leds class directory.
+ * @param index user led number.
+ * @return maximum brightness level.
+ */
+static unsigned int ReadMaxBrightness(const char *root, unsigned int index)
+{
+    char path[LED_PATH_SIZE];
+    unsigned int maxBrightness = 1;
+
+    snprintf(path, sizeof(path), LED_NAME_FORMAT, root, index, "max_brightness");
+    FILE *file = fopen(path, "r");
+    if (file != NULL)
+    {
+        if (fscanf(file, "%u", &maxBrightness) != 1 || maxBrightness == 0)
+        {
+            maxBrightness = 1;
+        }
+        fclose(file);
+    }
+    return maxBrightness;
+}
+
+bool Led_Open(Led *led, const char *root, unsigned int index)
+{
+    char path[LED_PATH_SIZE];
+
+    led->index = index;
+    led->maxBrightness = ReadMaxBrightness(root, index);
+
+    snprintf(path, sizeof(path), LED_NAME_FORMAT, root, index, "brightness");
+    led->fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (led->fd < 0)
+    {
+        LOG(LOG_ERR, "Failed to open %s", path);
+        return false;
+    }
+    return true;
+}
+
+int Led_Set(Led *led, unsigned int level)
+{
+    char buffer[LED_LEVEL_SIZE];
+
+    if (led->fd < 0)
+    {
+        return -1;
+    }
+
+#ifdef ENABLE_FAULT_INJECTION
+    if (Fault_Inject(Fault_LedSlow))
+    {
+        usleep(Fault_SlowMs() * 1000);
+    }
+    if (Fault_Inject(Fault_LedFail))
+    {
+        return -1;
+    }
+#endif
+
+    if (level > led->maxBrightness)
+    {
+        level = led->maxBrightness;
+    }
+
+    int length = snprintf(buffer, sizeof(buffer), "%u\n", level);
+    if (pwrite(led->fd, buffer, length, 0) != length)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+void Led_Close(Led *led)
+{
+    if (led->fd >= 0)
+    {
+        close(led->fd);
+        led->fd = -1;
+    }
+}
@@ -0,0 +1,81 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file led.h
+ * @brief Control of on board leds through the sysfs leds class.
+ */
+
+#ifndef LED_H
+#define LED_H
+
+#include <stdbool.h>
+
+/** Default location of the sysfs leds class. */
+#define LED_SYSFS_ROOT "/sys/class/leds"
+
+/**
+ * A structure to contain an open led.
+ */
+typedef struct
+{
+    /*@{*/
+    unsigned int index; /**< user led number on the board */
+    int fd; /**< brightness attribute, -1 if it could not be opened */
+    unsigned int maxBrightness; /**< largest brightness level the led accepts */
+    /*@}*/
+}Led;
+
+/**
+ * @brief Open the brightness attribute of a user led. The attribute is kept open so that every
+ *        update is a single write.
+ * @param *led led to initialise.
+ * @param *root sysfs leds class directory.
+ * @param index user led number.
+ * @return true on success, else false. On failure the led is still safe to use and every
+ *         update reports failure.
+ */
+bool Led_Open(Led *led, const char *root, unsigned int index);
+
+/**
+ * @brief Set led brightness.
+ * @param *led led to update.
+ * @param level brightness, clamped to the led's maximum.
+ * @return 0 on success, else -1.
+ */
+int Led_Set(Led *led, unsigned int level);
+
+/**
+ * @brief Close a led.
+ * @param *led led to close.
+ */
+void Led_Close(Led *led);
+
+#endif  /* LED_H */
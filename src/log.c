@@ -0,0 +1,164 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file log.c
+ * @brief Log line formatting and output.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdarg.h>
+
+#include "log.h"
+#include "ring_log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define LOG_SUFFIX                  ANSI_COLOR_RESET "\n"
+#define LOG_SUFFIX_LENGTH           (sizeof(LOG_SUFFIX) - 1)
+//! @endcond
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/** Ring log receiving logs, if open. */
+static RingLog g_ringLog = { -1, NULL, NULL, 0 };
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Append formatted text to a buffer, never past its end.
+ * @param *buffer buffer to append to.
+ * @param size usable size of buffer.
+ * @param length current length of text in buffer.
+ * @param *format printf style format.
+ * @return new length of text in buffer.
+ */
+static size_t Append(char *buffer, size_t size, size_t length, const char *format, ...)
+{
+    va_list args;
+    int written;
+
+    if (length >= size)
+    {
+        return size;
+    }
+
+    va_start(args, format);
+    written = vsnprintf(buffer + length, size - length, format, args);
+    va_end(args);
+
+    if (written < 0)
+    {
+        return length;
+    }
+    return (length + written < size) ? length + written : size - 1;
+}
+
+void Log_Message(int level, const char *file, int line, const char *format, ...)
+{
+    char buffer[LOG_BUFFER_SIZE];
+    /* Keep room for the colour reset and newline even when the message is truncated */
+    size_t size = sizeof(buffer) - LOG_SUFFIX_LENGTH;
+    size_t length = 0;
+    va_list args;
+    int written;
+
+    length = Append(buffer, size, length, "\n");
+    if (g_debugLevel == LOG_DBG)
+    {
+        time_t currentTime = time(NULL);
+        struct tm localTime;
+        char timeBuffer[TIME_BUFFER_SIZE] = {0};
+
+        strftime(timeBuffer, TIME_BUFFER_SIZE, "%x %X", localtime_r(&currentTime, &localTime));
+        length = Append(buffer, size, length, "[%s] " ANSI_COLOR_YELLOW "%s:%d: " ANSI_COLOR_RESET, timeBuffer, file, line);
+    }
+
+    switch (level)
+    {
+        case LOG_ERR:
+            length = Append(buffer, size, length, ANSI_COLOR_RED);
+            break;
+        case LOG_INFO:
+            length = Append(buffer, size, length, ANSI_COLOR_CYAN);
+            break;
+        default:
+            break;
+    }
+
+    if (length < size)
+    {
+        va_start(args, format);
+        written = vsnprintf(buffer + length, size - length, format, args);
+        va_end(args);
+        if (written > 0)
+        {
+            length = (length + written < size) ? length + written : size - 1;
+        }
+    }
+
+    memcpy(buffer + length, LOG_SUFFIX, LOG_SUFFIX_LENGTH);
+    length += LOG_SUFFIX_LENGTH;
+
+    if (g_ringLog.header != NULL)
+    {
+        RingLog_Write(&g_ringLog, buffer, length);
+    }
+    else
+    {
+        if (g_debugStream == NULL)
+        {
+            g_debugStream = stdout;
+        }
+        fwrite(buffer, 1, length, g_debugStream);
+        fflush(g_debugStream);
+    }
+}
+
+bool Log_OpenRing(const char *path, size_t size)
+{
+    Log_CloseRing();
+    return RingLog_Open(&g_ringLog, path, size);
+}
+
+void Log_CloseRing(void)
+{
+    RingLog_Close(&g_ringLog);
+}
@@ -36,6 +36,7 @@
 #ifndef LOG_H
 #define LOG_H
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -54,54 +55,45 @@
 #define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 
 #define TIME_BUFFER_SIZE  (32)
+#define LOG_BUFFER_SIZE   (512)
 //! \}
 
-/** Macro for printing logging message with current time, function and line no. */
-#define DEBUG_PRINT                                                           \
-    do {                                                                      \
-        time_t currentTime = time(NULL);                                      \
-        char buffer[TIME_BUFFER_SIZE] = {0};                                  \
-        strftime(buffer, TIME_BUFFER_SIZE, "%x %X", localtime(&currentTime)); \
-        fprintf(g_debugStream,"[%s] ", buffer);                                 \
-        fprintf(g_debugStream, ANSI_COLOR_YELLOW);                              \
-        fprintf(g_debugStream,"%s:%d: ", __FILENAME__, __LINE__);               \
-        fprintf(g_debugStream, ANSI_COLOR_RESET);                               \
-    } while (0)
-
 /** Macro for logging message at the specified level. */
-#define LOG(level, ...)                                       \
-    do {                                                      \
-        if (level <= g_debugLevel)                              \
-        {                                                     \
-            if (g_debugStream == NULL)                          \
-                g_debugStream = stdout;                         \
-            fprintf(g_debugStream, "\n");                       \
-            if (g_debugLevel == LOG_DBG)                        \
-            {                                                 \
-                DEBUG_PRINT;                                  \
-            }                                                 \
-            switch (level)                                    \
-            {                                                 \
-                case LOG_ERR:                                 \
-                    fprintf(g_debugStream, ANSI_COLOR_RED);     \
-                    break;                                    \
-                case LOG_INFO:                                \
-                    fprintf(g_debugStream, ANSI_COLOR_CYAN);    \
-                    break;                                    \
-                default:                                      \
-                    break;                                    \
-            }                                                 \
-            fprintf(g_debugStream, __VA_ARGS__);                \
-            fprintf(g_debugStream, ANSI_COLOR_RESET);           \
-            fprintf(g_debugStream, "\n");                       \
-            fflush(g_debugStream);                              \
-        }                                                     \
+#define LOG(level, ...)                                                   \
+    do {                                                                  \
+        if (level <= g_debugLevel)                                        \
+        {                                                                 \
+            Log_Message(level, __FILENAME__, __LINE__, __VA_ARGS__);      \
+        }                                                                 \
     } while (0)
 
-/** Output stream to dump logs. */
+/** Output stream to dump logs, used when no ring log is open. */
 extern FILE *g_debugStream;
 /** Debug level for logs. */
 extern int g_debugLevel;
 
+/**
+ * @brief Format a log line, with current time, file and line no. at debug level, and write it to
+ *        the ring log if one is open, else to g_debugStream, in a single write.
+ * @param level level of the message.
+ * @param *file source file logging the message.
+ * @param line source line logging the message.
+ * @param *format printf style format of the message.
+ */
+void Log_Message(int level, const char *file, int line, const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+/**
+ * @brief Send logs to a size-bounded ring log file instead of g_debugStream.
+ * @param *path log file.
+ * @param size size of the log data area in bytes.
+ * @return true on success, else false.
+ */
+bool Log_OpenRing(const char *path, size_t size);
+
+/**
+ * @brief Close the ring log, if open. Later logs go to g_debugStream.
+ */
+void Log_CloseRing(void);
 
 #endif  /* LOG_H */
@@ -0,0 +1,255 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file logread.c
+ * @brief Prints the records of a motion_led_controller_appd ring log in order, oldest first.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ring_log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define FOLLOW_PERIOD_US            (200000)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Prints motion_led_controller_logread usage.
+ * @param *program holds application name.
+ */
+static void PrintUsage(const char *program)
+{
+    printf("Usage: %s [options] <log file>\n\n"
+            " -f : Keep printing records as they are written.\n"
+            " -h : Print help and exit.\n\n",
+            program);
+}
+
+/**
+ * @brief Copy the bytes logged between two positions out of the log, each to its own offset.
+ * @param *data data area of the log.
+ * @param size size of the data area.
+ * @param *copy buffer of the same size as the data area.
+ * @param from position of the first byte.
+ * @param to position after the last byte.
+ */
+static void CopyRange(const char *data, uint32_t size, char *copy, uint32_t from, uint32_t to)
+{
+    while (from != to)
+    {
+        uint32_t offset = from & (size - 1);
+        uint32_t length = size - offset;
+
+        if (length > to - from)
+        {
+            length = to - from;
+        }
+        memcpy(copy + offset, data + offset, length);
+        from += length;
+    }
+}
+
+/**
+ * @brief Write the bytes logged between two positions to stdout.
+ * @param *copy copy of the data area.
+ * @param size size of the data area.
+ * @param from position of the first byte.
+ * @param to position after the last byte.
+ */
+static void PrintRange(const char *copy, uint32_t size, uint32_t from, uint32_t to)
+{
+    while (from != to)
+    {
+        uint32_t offset = from & (size - 1);
+        uint32_t length = size - offset;
+
+        if (length > to - from)
+        {
+            length = to - from;
+        }
+        fwrite(copy + offset, 1, length, stdout);
+        from += length;
+    }
+}
+
+/**
+ * @brief Print the complete records from a position up to the head. They are copied out first,
+ *        and anything the writer overwrote during the copy is dropped afterwards, so a record is
+ *        never printed half old and half new.
+ * @param *header header of the log.
+ * @param *data data area of the log.
+ * @param *copy buffer of the same size as the data area.
+ * @param position first position to print.
+ * @param lost true if the bytes before position are already lost.
+ * @return position after the last byte printed.
+ */
+static uint32_t PrintRecords(const RingLogHeader *header, const char *data, char *copy, uint32_t position, bool lost)
+{
+    uint32_t size = header->size;
+    uint32_t head = header->head;
+
+    if (head - position > size)
+    {
+        /* The writer lapped the reader, so position no longer starts a record */
+        printf("\n--- %lu bytes overwritten before they could be read ---\n",
+                (unsigned long)(head - size - position));
+        position = head - size;
+        lost = true;
+    }
+    __sync_synchronize();
+    CopyRange(data, size, copy, position, head);
+    __sync_synchronize();
+
+    /* Bytes before reserved - size may have been overwritten while they were copied */
+    uint32_t oldest = header->wrapped ? header->reserved - size : 0;
+    if ((int32_t)(oldest - position) > 0)
+    {
+        if (!lost)
+        {
+            printf("\n--- %lu bytes overwritten before they could be read ---\n",
+                    (unsigned long)(oldest - position));
+        }
+        position = oldest;
+        lost = true;
+    }
+
+    if (lost)
+    {
+        position = RingLog_OldestRecord(copy, size, position, head);
+    }
+    PrintRange(copy, size, position, head);
+    fflush(stdout);
+    return head;
+}
+
+/**
+ * @brief Motion-Led controller log reader prints the ring log, optionally following it.
+ */
+int main(int argc, char **argv)
+{
+    struct stat status;
+    bool follow = false;
+    int opt;
+
+    opterr = 0;
+    while ((opt = getopt(argc, argv, "fh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'f':
+                follow = true;
+                break;
+            case 'h':
+                PrintUsage(argv[0]);
+                return 0;
+            default:
+                PrintUsage(argv[0]);
+                return -1;
+        }
+    }
+
+    if (optind >= argc)
+    {
+        PrintUsage(argv[0]);
+        return -1;
+    }
+
+    int fd = open(argv[optind], O_RDONLY);
+    if (fd < 0 || fstat(fd, &status) != 0)
+    {
+        fprintf(stderr, "Failed to open %s\n", argv[optind]);
+        return -1;
+    }
+
+    if ((size_t)status.st_size < RING_LOG_HEADER_SIZE + RING_LOG_MIN_SIZE)
+    {
+        fprintf(stderr, "%s is not a ring log\n", argv[optind]);
+        close(fd);
+        return -1;
+    }
+
+    void *mapping = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        fprintf(stderr, "Failed to map %s\n", argv[optind]);
+        close(fd);
+        return -1;
+    }
+
+    const RingLogHeader *header = mapping;
+    const char *data = (const char *)mapping + RING_LOG_HEADER_SIZE;
+    uint32_t size = header->size;
+    char *copy = NULL;
+
+    if (header->magic != RING_LOG_MAGIC || header->version != RING_LOG_VERSION ||
+        (size & (size - 1)) != 0 || RING_LOG_HEADER_SIZE + (off_t)size != status.st_size ||
+        (copy = malloc(size)) == NULL)
+    {
+        fprintf(stderr, "%s is not a ring log\n", argv[optind]);
+        munmap(mapping, status.st_size);
+        close(fd);
+        return -1;
+    }
+
+    /* Once the log has wrapped, its oldest record is usually partly overwritten */
+    bool wrapped = header->wrapped;
+    uint32_t position = wrapped ? header->reserved - size : 0;
+
+    position = PrintRecords(header, data, copy, position, wrapped);
+    while (follow)
+    {
+        usleep(FOLLOW_PERIOD_US);
+        position = PrintRecords(header, data, copy, position, false);
+    }
+
+    free(copy);
+    munmap(mapping, status.st_size);
+    close(fd);
+    return 0;
+}
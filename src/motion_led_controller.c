@@ -31,22 +31,34 @@
 /**
  * @file motion_led_controller.c
  * @brief Motion-Led controller application observes the IPSO resource for motion sensor on constrained device.
- *        On receipt of AwaLWM2M notification, ci40 will glow on board led for a period of 5 seconds.
- *        If further notifications are observed during the 5 second period then time out is restarted.
+ *        On receipt of AwaLWM2M notification, ci40 will fade in on board led and hold it for a period of
+ *        5 seconds before fading out. If further notifications are observed during the 5 second period
+ *        then time out is restarted, and a notification during the fade out brings the led back up from
+ *        wherever the fade has got to.
  */
 
 /***************************************************************************************************
  * Includes
  **************************************************************************************************/
 
+#define _GNU_SOURCE
+#include <dlfcn.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <signal.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include "awa/server.h"
+#include "clock.h"
+#include "led.h"
 #include "log.h"
+#include "pool.h"
+#include "ring_log.h"
+#include "startup_profile.h"
+#include "trace.h"
+#include "transition.h"
 
 /***************************************************************************************************
  * Definitions
@@ -66,11 +78,24 @@
 #define MAX_INSTANCES               (1)
 #define OPERATION_TIMEOUT           (5000)
 #define URL_PATH_SIZE               (16)
-#define ALARM_PERIOD                (5)
-#define LED_OFF                     "0"
-#define LED_ON                      "1"
-#define SENSOR_LED_INDEX            "1"
-#define HEARTBEAT_LED_INDEX         "2"
+#define HOLD_PERIOD                 (5)
+#define FADE_IN_MS                  (250)
+#define FADE_OUT_MS                 (1500)
+#define FRAME_RATE                  (50)
+#define SENSOR_OUTPUT               (0)
+#define HEARTBEAT_PERIOD_MS         (1000)
+#define HEARTBEAT_ON_MS             (100)
+#define PROCESS_RETRY_MS            (1000)
+#define REOBSERVE_BACKOFF_MIN_MS    (1000)
+#define REOBSERVE_BACKOFF_MAX_MS    (30000)
+#define LED_OFF                     (0)
+#define LED_ON                      (1)
+#define SENSOR_LED                  (1)
+#define HEARTBEAT_LED               (2)
+#define DEFAULT_EVENT_CAPACITY      (16)
+#define OBSERVE_ATTEMPTS            (3)
+#define MAX_PROCESS_FAILURES        (5)
+#define DEFAULT_LOG_SIZE            (64 * 1024)
 //! @endcond
 
 /***************************************************************************************************
@@ -105,6 +130,36 @@ typedef struct
     /*@}*/
 }Object;
 
+/**
+ * A structure to contain a sensor notification queued for the main loop.
+ */
+typedef struct SensorEvent
+{
+    /*@{*/
+    struct SensorEvent *next; /**< next event in queue */
+    AwaObjectID objectID; /**< object ID of notifying resource */
+    AwaResourceID resourceID; /**< resource ID of notifying resource */
+    AwaInteger value; /**< reported sensor value */
+    uint64_t timestampNs; /**< monotonic time notification was received */
+    /*@}*/
+}SensorEvent;
+
+/** Signature of AllocCount_Get() in the preloaded allocation counter. */
+typedef unsigned long (*AllocCountFunction)(void);
+
+/**
+ * A structure to contain state of the device discovery thread.
+ */
+typedef struct
+{
+    /*@{*/
+    pthread_t thread; /**< discovery thread */
+    bool started; /**< true if discovery thread has been started and not yet joined */
+    volatile bool cancel; /**< set to stop discovery early */
+    bool registered; /**< true once all constrained devices have registered */
+    /*@}*/
+}DeviceDiscovery;
+
 /***************************************************************************************************
  * Globals
  **************************************************************************************************/
@@ -117,6 +172,28 @@ FILE *g_debugStream = NULL;
 unsigned int g_sensorState = false;
 /** Global variable for signal handling. */
 static volatile int g_quit = 0;
+/** Pool of queued sensor events. */
+static Pool g_eventPool;
+/** Oldest queued sensor event. */
+static SensorEvent *g_eventHead = NULL;
+/** Newest queued sensor event. */
+static SensorEvent *g_eventTail = NULL;
+/** Number of notifications merged into the newest event because the pool was exhausted. */
+static unsigned long g_coalescedEvents = 0;
+/** Led showing motion. */
+static Led g_sensorLed = { SENSOR_LED, -1, 1 };
+/** Led toggled by the main loop to show it is alive. */
+static Led g_heartbeatLed = { HEARTBEAT_LED, -1, 1 };
+/** Outputs of the transition engine. */
+static TransitionOutput g_outputs[1];
+/** Transition engine fading the sensor led. */
+static TransitionEngine g_transitions;
+/** Set when the sensor device registers, the server then has no observation of it. */
+static bool g_sensorRegistered = false;
+/** Set when the sensor device deregisters. */
+static bool g_sensorDeregistered = false;
+/** Path of observed sensor resource, generated once at start up. */
+static char g_sensorPath[URL_PATH_SIZE] = {0};
 
 /** Initializing objects. */
 static Object objects[] =
@@ -148,7 +225,7 @@ static Object objects[] =
  */
 static void CtrlCSignalHandler(int dummy)
 {
-    LOG(LOG_INFO, "Exit triggered");
+    /* Nothing is logged here, the log lock may be held by the code that was interrupted */
     g_quit = 1;
 }
 
@@ -160,29 +237,11 @@ static void CtrlCSignalHandler(int dummy)
 static void UpdateLed(bool status, bool isHeartbeat)
 {
     int tmp = 0;
+    Led *led = isHeartbeat ? &g_heartbeatLed : &g_sensorLed;
 
-    if (status)
-    {
-        if (isHeartbeat)
-        {
-            tmp = system("/usr/bin/set_led.sh " HEARTBEAT_LED_INDEX " " LED_ON);
-        }
-        else
-        {
-            tmp = system("/usr/bin/set_led.sh " SENSOR_LED_INDEX " " LED_ON);
-        }
-    }
-    else
-    {
-        if (isHeartbeat)
-        {
-            tmp = system("/usr/bin/set_led.sh " HEARTBEAT_LED_INDEX " " LED_OFF);
-        }
-        else
-        {
-            tmp = system("/usr/bin/set_led.sh " SENSOR_LED_INDEX " " LED_OFF);
-        }
-    }
+    TRACE2(led_write_entry, led->index, status);
+    tmp = Led_Set(led, status ? LED_ON : LED_OFF);
+    TRACE3(led_write_exit, led->index, status, tmp);
 
     if (tmp != 0)
     {
@@ -197,26 +256,32 @@ static void UpdateLed(bool status, bool isHeartbeat)
 static void PrintUsage(const char *program)
 {
     printf("Usage: %s [options]\n\n"
-            " -l : Log filename.\n"
+            " -l : Log filename. The log is a ring of fixed size, print it with\n"
+            "      motion_led_controller_logread.\n"
+            " -s : Log size in bytes, at least %d, rounded up to a power of two,\n"
+            "      default is %d.\n"
+            " -r : Sysfs leds directory, default is " LED_SYSFS_ROOT ".\n"
+            " -q : Capacity of sensor event queue, default is %d.\n"
             " -v : Debug level from 1 to 5\n"
             "      fatal(1), error(2), warning(3), info(4), debug(5) and max(>5)\n"
             "      default is info.\n"
             " -h : Print help and exit.\n\n",
-            program);
+            program, RING_LOG_MIN_SIZE, DEFAULT_LOG_SIZE, DEFAULT_EVENT_CAPACITY);
 }
 
 /**
  * @brief Parses command line arguments passed to motion_led_controller_appd.
  * @return -1 in case of failure, 0 for printing help and exit, and 1 for success.
  */
-static int ParseCommandArgs(int argc, char *argv[], const char **fptr)
+static int ParseCommandArgs(int argc, char *argv[], const char **fptr, size_t *logSize,
+    const char **ledRoot, unsigned int *eventCapacity)
 {
     int opt, tmp;
     opterr = 0;
 
     while (1)
     {
-        opt = getopt(argc, argv, "l:v:");
+        opt = getopt(argc, argv, "l:s:r:q:v:");
         if (opt == -1)
         {
             break;
@@ -227,6 +292,31 @@ static int ParseCommandArgs(int argc, char *argv[], const char **fptr)
             case 'l':
                 *fptr = optarg;
                 break;
+            case 's':
+                *logSize = strtoul(optarg, NULL, 0);
+                if (*logSize < RING_LOG_MIN_SIZE || *logSize > RING_LOG_MAX_SIZE)
+                {
+                    LOG(LOG_ERR, "Invalid log size");
+                    PrintUsage(argv[0]);
+                    return -1;
+                }
+                break;
+            case 'r':
+                *ledRoot = optarg;
+                break;
+            case 'q':
+                tmp = strtoul(optarg, NULL, 0);
+                if (tmp > 0)
+                {
+                    *eventCapacity = tmp;
+                }
+                else
+                {
+                    LOG(LOG_ERR, "Invalid event queue capacity");
+                    PrintUsage(argv[0]);
+                    return -1;
+                }
+                break;
             case 'v':
                 tmp = strtoul(optarg, NULL, 0);
                 if (tmp >= LOG_FATAL && tmp <= LOG_DBG)
@@ -253,23 +343,27 @@ static int ParseCommandArgs(int argc, char *argv[], const char **fptr)
 }
 
 /**
- * @brief Turn off the light when 5 second timer run out signal is received.
+ * @brief Called by the transition engine when the light starts fading out after the 5 second hold.
+ * @param output transition engine output being released.
  */
-void TurnOffLight(int signal)
+static void OnSensorRelease(unsigned int output)
 {
-    UpdateLed(false, false);
+    TRACE2(light_off, MOTION_OBJECT_ID, MOTION_RESOURCE_ID);
 	LOG(LOG_INFO, "Turn OFF led on Ci40 board");
 }
 
 /**
- * @brief Turn on the light when notification is received.
+ * @brief Turn on the light when notification is received, fading in from its current level and
+ *        scheduling the fade out.
+ * @param now current monotonic time in nanoseconds.
  */
-void TurnOnLight()
+static void TurnOnLight(uint64_t now)
 {
-	signal(SIGALRM, TurnOffLight);
-    UpdateLed(true, false);
+    Transition_Start(&g_transitions, SENSOR_OUTPUT, TRANSITION_LEVEL_MAX, FADE_IN_MS, now);
+    Transition_Release(&g_transitions, SENSOR_OUTPUT, now + HOLD_PERIOD * NSEC_PER_SEC, FADE_OUT_MS);
+    Transition_Frame(&g_transitions, now);
+    TRACE2(light_on, MOTION_OBJECT_ID, MOTION_RESOURCE_ID);
 	LOG(LOG_INFO, "Turn ON led on Ci40 board\n");
-	alarm(ALARM_PERIOD);
 }
 
 /**
@@ -279,42 +373,85 @@ void TurnOnLight()
  */
 void ObserveCallback(const AwaChangeSet *changeSet, void *context)
 {
-    char path[URL_PATH_SIZE] = {0};
     const AwaInteger *value = NULL;
-    const AwaServerSession *serverSession = AwaChangeSet_GetServerSession(changeSet);
+    uint64_t now = Clock_NowNs();
 
-    if (AwaAPI_MakeResourcePath(path, URL_PATH_SIZE, MOTION_OBJECT_ID, 0, MOTION_RESOURCE_ID) != AwaError_Success)
+    if (AwaChangeSet_GetValueAsIntegerPointer(changeSet, g_sensorPath, &value) == AwaError_Success)
     {
-        LOG(LOG_INFO, "Couldn't generate all object and resource paths.");
-    }
+        TRACE4(observe_callback, MOTION_OBJECT_ID, MOTION_RESOURCE_ID, *value, now);
+        g_sensorState = *value;
+        LOG(LOG_INFO, "Received observe callback for sensor object[%d/0/%d] with value %d", MOTION_OBJECT_ID, MOTION_RESOURCE_ID, g_sensorState);
 
-    if (path != NULL)
-    {
-        AwaObjectID objectID = AWA_INVALID_ID;
-        AwaObjectInstanceID objectInstanceID = AWA_INVALID_ID;
-        AwaResourceID resourceID = AWA_INVALID_ID;
+        SensorEvent *event = Pool_Alloc(&g_eventPool);
+        if (event == NULL)
+        {
+            /* Queue full, the newest event still carries the latest state */
+            if (g_eventTail != NULL)
+            {
+                g_eventTail->value = *value;
+                g_eventTail->timestampNs = now;
+            }
+            g_coalescedEvents++;
+            return;
+        }
 
-        AwaServerSession_PathToIDs(serverSession, path, &objectID, &objectInstanceID, &resourceID);
+        event->next = NULL;
+        event->objectID = MOTION_OBJECT_ID;
+        event->resourceID = MOTION_RESOURCE_ID;
+        event->value = *value;
+        event->timestampNs = now;
 
-        if (AwaChangeSet_GetValueAsIntegerPointer(changeSet, path, &value) == AwaError_Success)
+        if (g_eventTail != NULL)
         {
-            g_sensorState = *value;
-            LOG(LOG_INFO, "Received observe callback for sensor object[%d/0/%d] with value %d", MOTION_OBJECT_ID, MOTION_RESOURCE_ID, g_sensorState);
+            g_eventTail->next = event;
         }
+        else
+        {
+            g_eventHead = event;
+        }
+        g_eventTail = event;
     }
 }
 
+/**
+ * @brief Take the oldest sensor event off the queue. The caller returns it to g_eventPool.
+ * @return oldest event, or NULL if the queue is empty.
+ */
+static SensorEvent *PopSensorEvent(void)
+{
+    SensorEvent *event = g_eventHead;
+
+    if (event != NULL)
+    {
+        g_eventHead = event->next;
+        if (g_eventHead == NULL)
+        {
+            g_eventTail = NULL;
+        }
+    }
+    return event;
+}
+
 /**
  * @brief Observe sensor status on server and call for update in case of changes.
  * @param *session holds server session.
+ * @param **observation set to the observation, to be kept until StopObservingSensor().
  * @return true if observing sensor has been set successfully, else false.
  */
-static bool StartObservingSensor(const AwaServerSession *session)
+static bool StartObservingSensor(const AwaServerSession *session, AwaServerObservation **observation)
 {
     AwaServerObserveOperation *operation = NULL;
-    char sensorResourcePath[URL_PATH_SIZE] = {0};
+    const char *sensorResourcePath = g_sensorPath;
     const AwaPathResult *pathResult = NULL;
-    bool result = true;
+    bool result = false;
+
+    *observation = NULL;
+
+    if (AwaAPI_MakeResourcePath(g_sensorPath, URL_PATH_SIZE, MOTION_OBJECT_ID, 0, MOTION_RESOURCE_ID) != AwaError_Success)
+    {
+        LOG(LOG_INFO, "Couldn't generate all object and resource paths");
+        return false;
+    }
 
     operation = AwaServerObserveOperation_New(session);
     if (operation == NULL)
@@ -323,28 +460,21 @@ static bool StartObservingSensor(const AwaServerSession *session)
         return false;
     }
 
-    if (AwaAPI_MakeResourcePath(sensorResourcePath, URL_PATH_SIZE, MOTION_OBJECT_ID, 0, MOTION_RESOURCE_ID) != AwaError_Success)
+    *observation = AwaServerObservation_New(MOTION_DEVICE_STR, sensorResourcePath, ObserveCallback, NULL);
+    if (*observation == NULL)
     {
-        LOG(LOG_INFO, "Couldn't generate all object and resource paths");
-        return false;
+        LOG(LOG_ERR, "AwaServerObservation_New failed");
     }
-
-    AwaServerObservation *observation = AwaServerObservation_New(MOTION_DEVICE_STR, sensorResourcePath, ObserveCallback, NULL);
-
-    if (observation != NULL)
+    else if (AwaServerObserveOperation_AddObservation(operation, *observation) != AwaError_Success)
+    {
+        LOG(LOG_ERR, "AwaServerObserveOperation_AddObservation failed");
+    }
+    else if (AwaServerObserveOperation_Perform(operation, OPERATION_TIMEOUT) != AwaError_Success)
+    {
+        LOG(LOG_ERR, "Failed to perform observe operation");
+    }
+    else
     {
-        if (AwaServerObserveOperation_AddObservation(operation, observation) != AwaError_Success)
-        {
-            LOG(LOG_ERR, "AwaServerObserveOperation_AddObservation failed");
-            result = false;
-        }
-
-        if (AwaServerObserveOperation_Perform(operation, OPERATION_TIMEOUT) != AwaError_Success)
-        {
-            LOG(LOG_ERR, "Failed to perform observe operation");
-            result = false;
-        }
-
         const AwaServerObserveResponse *response = NULL;
         response = AwaServerObserveOperation_GetResponse(operation, MOTION_DEVICE_STR);
 
@@ -352,50 +482,102 @@ static bool StartObservingSensor(const AwaServerSession *session)
         if (AwaPathResult_GetError(pathResult) != AwaError_Success)
         {
             LOG(LOG_ERR, "AwaServerObserveResponse_GetPathResult failed\n");
-            result = false;
         }
+        else
+        {
+            LOG(LOG_INFO, "Successfully added observe operation for sensor object[%d/0/%d]", MOTION_OBJECT_ID, MOTION_RESOURCE_ID);
+            result = true;
+        }
+    }
+
+    AwaServerObserveOperation_Free(&operation);
 
-        LOG(LOG_INFO, "Successfully added observe operation for sensor object[%d/0/%d]", MOTION_OBJECT_ID, MOTION_RESOURCE_ID);
+    if (!result && *observation != NULL)
+    {
+        AwaServerObservation_Free(observation);
+    }
+    return result;
+}
 
+/**
+ * @brief Cancel observation of sensor status and release it.
+ * @param *session holds server session.
+ * @param **observation observation returned by StartObservingSensor(), set to NULL.
+ */
+static void StopObservingSensor(const AwaServerSession *session, AwaServerObservation **observation)
+{
+    if (*observation == NULL)
+    {
+        return;
+    }
+
+    AwaServerObserveOperation *operation = AwaServerObserveOperation_New(session);
+    if (operation != NULL)
+    {
+        if (AwaServerObserveOperation_AddCancelObservation(operation, *observation) != AwaError_Success ||
+            AwaServerObserveOperation_Perform(operation, OPERATION_TIMEOUT) != AwaError_Success)
+        {
+            LOG(LOG_WARN, "Failed to cancel observation of sensor object[%d/0/%d]", MOTION_OBJECT_ID, MOTION_RESOURCE_ID);
+        }
         AwaServerObserveOperation_Free(&operation);
     }
 
+    if (AwaServerObservation_Free(observation) != AwaError_Success)
+    {
+        LOG(LOG_WARN, "Failed to free sensor observation");
+    }
+}
+
+/**
+ * @brief Walk a client list looking for a client, and free it.
+ * @param *clientIterator client list, may be NULL.
+ * @param *endPointName holds client name.
+ * @return true if the client is in the list, else false.
+ */
+static bool ListsClient(AwaClientIterator *clientIterator, const char *endPointName)
+{
+    bool result = false;
+
+    if (clientIterator == NULL)
+    {
+        return false;
+    }
+    while(AwaClientIterator_Next(clientIterator))
+    {
+        if (!strcmp(endPointName, AwaClientIterator_GetClientID(clientIterator)))
+        {
+            result = true;
+            break;
+        }
+    }
+    AwaClientIterator_Free(&clientIterator);
     return result;
 }
 
 /**
  * @brief Check to see if a constrained device by the name endPointName has registered
  *        itself with the server on the gateway or not.
- * @param *session holds server session.
+ * @param *operation list clients operation, reused across checks.
  * @param *endPointName holds client name.
  * @return true if constrained device is in client list i.e. registered, else false.
  */
-static bool CheckConstrainedRegistered(const AwaServerSession *session, const char *endPointName)
+static bool CheckConstrainedRegistered(AwaServerListClientsOperation *operation, const char *endPointName)
 {
     bool result = false;
     AwaError error;
 
-    AwaServerListClientsOperation *operation = AwaServerListClientsOperation_New(session);
     if (operation != NULL)
     {
         if ((error = AwaServerListClientsOperation_Perform(operation, OPERATION_TIMEOUT)) == AwaError_Success)
         {
-            AwaClientIterator *clientIterator = NULL;
-            clientIterator = AwaServerListClientsOperation_NewClientIterator(operation);
+            AwaClientIterator *clientIterator = AwaServerListClientsOperation_NewClientIterator(operation);
             if (clientIterator != NULL)
             {
-                while(AwaClientIterator_Next(clientIterator))
+                result = ListsClient(clientIterator, endPointName);
+                if (result)
                 {
-                    const char *clientID = AwaClientIterator_GetClientID(clientIterator);
-
-                    if (!strcmp(endPointName, clientID))
-                    {
-                        LOG(LOG_INFO, "Constrained device %s registered", endPointName);
-                        result = true;
-                        break;
-                    }
+                    LOG(LOG_INFO, "Constrained device %s registered", endPointName);
                 }
-                AwaClientIterator_Free(&clientIterator);
             }
             else
             {
@@ -406,17 +588,36 @@ static bool CheckConstrainedRegistered(const AwaServerSession *session, const ch
         {
             LOG(LOG_ERR, "AwaServerListClientsOperation_Perform failed\nerror: %s", AwaError_ToString(error));
         }
+    }
+    return result;
+}
 
-        if ((error = AwaServerListClientsOperation_Free(&operation)) != AwaError_Success)
-        {
-            LOG(LOG_ERR, "AwaServerListClientsOperation_Free failed\nerror: %s", AwaError_ToString(error));
-        }
+/**
+ * @brief Called from AwaServerSession_DispatchCallbacks() when clients register.
+ * @param *event register event.
+ * @param *context unused.
+ */
+static void ClientRegisterCallback(const AwaServerClientRegisterEvent *event, void *context)
+{
+    if (ListsClient(AwaServerClientRegisterEvent_NewClientIterator(event), MOTION_DEVICE_STR))
+    {
+        LOG(LOG_INFO, "Constrained device %s registered", MOTION_DEVICE_STR);
+        g_sensorRegistered = true;
     }
-    else
+}
+
+/**
+ * @brief Called from AwaServerSession_DispatchCallbacks() when clients deregister.
+ * @param *event deregister event.
+ * @param *context unused.
+ */
+static void ClientDeregisterCallback(const AwaServerClientDeregisterEvent *event, void *context)
+{
+    if (ListsClient(AwaServerClientDeregisterEvent_NewClientIterator(event), MOTION_DEVICE_STR))
     {
-        LOG(LOG_ERR, "AwaServerListClientsOperation_New failed");
+        LOG(LOG_WARN, "Constrained device %s deregistered", MOTION_DEVICE_STR);
+        g_sensorDeregistered = true;
     }
-    return result;
 }
 
 /**
@@ -475,7 +676,9 @@ static AwaObjectDefinition *AddResourceDefinitions(Object *object)
 }
 
 /**
- * @brief Define all objects and its resources with server deamon.
+ * @brief Define all objects and its resources with server deamon. The server is the authority on
+ *        what is defined: only objects it does not report are built and defined. The check is
+ *        local, as the session fetches the server's definitions when it connects.
  * @param *session holds server session.
  * @return true if object is successfully defined on server, else false.
  */
@@ -484,6 +687,7 @@ bool DefineServerObjects(AwaServerSession *session)
     unsigned int i;
     unsigned int definitionCount = 0;
     bool result = true;
+    AwaServerDefineOperation *handler = NULL;
 
     if (session == NULL)
     {
@@ -491,23 +695,23 @@ bool DefineServerObjects(AwaServerSession *session)
         return false;
     }
 
-    AwaServerDefineOperation *handler = AwaServerDefineOperation_New(session);
-    if (handler == NULL)
-    {
-        LOG(LOG_ERR, "Failed to create define operation for session on server");
-        return false;
-    }
-
     for (i = 0; (i < ARRAY_SIZE(objects)) && result; i++)
     {
-        LOG(LOG_INFO, "Defining %s[%d] object on awalwm2m server", objects[i].name, objects[i].id);
-
         if (AwaServerSession_IsObjectDefined(session, objects[i].id))
         {
             LOG(LOG_DBG, "%s[%d] object already defined on server", objects[i].name, objects[i].id);
             continue;
         }
 
+        LOG(LOG_INFO, "Defining %s[%d] object on awalwm2m server", objects[i].name, objects[i].id);
+
+        /* Created only when something is missing, which after the first start is rarely the case */
+        if (handler == NULL && (handler = AwaServerDefineOperation_New(session)) == NULL)
+        {
+            LOG(LOG_ERR, "Failed to create define operation for session on server");
+            return false;
+        }
+
         AwaObjectDefinition *objectDefinition = AddResourceDefinitions(&objects[i]);
 
         if (objectDefinition != NULL)
@@ -530,7 +734,7 @@ bool DefineServerObjects(AwaServerSession *session)
             result = false;
         }
     }
-    if (AwaServerDefineOperation_Free(&handler) != AwaError_Success)
+    if (handler != NULL && AwaServerDefineOperation_Free(&handler) != AwaError_Success)
     {
         LOG(LOG_WARN, "Failed to free define operation object on server");
     }
@@ -579,33 +783,289 @@ AwaServerSession *Server_EstablishSession(unsigned int port, const char *address
     return session;
 }
 
+/**
+ * @brief Poll the server until every constrained device in the object table has registered.
+ * @param *session holds server session.
+ * @param *cancel flag to abandon the wait early.
+ * @return true if all devices registered, false if the wait was abandoned.
+ */
+static bool WaitForConstrainedDevices(const AwaServerSession *session, volatile bool *cancel)
+{
+    unsigned int i;
+    bool result = true;
+    AwaError error;
+
+    /* One operation is performed repeatedly rather than created for every poll */
+    AwaServerListClientsOperation *operation = AwaServerListClientsOperation_New(session);
+    if (operation == NULL)
+    {
+        LOG(LOG_ERR, "AwaServerListClientsOperation_New failed");
+        return false;
+    }
+
+    for (i = 0; (i < ARRAY_SIZE(objects)) && result; i++)
+    {
+        LOG(LOG_INFO, "Waiting for constrained device '%s' to be up", objects[i].clientID);
+        while (CheckConstrainedRegistered(operation, objects[i].clientID) == false)
+        {
+            if (g_quit || *cancel)
+            {
+                result = false;
+                break;
+            }
+            sleep(1 /*second*/);
+        }
+    }
+
+    if ((error = AwaServerListClientsOperation_Free(&operation)) != AwaError_Success)
+    {
+        LOG(LOG_ERR, "AwaServerListClientsOperation_Free failed\nerror: %s", AwaError_ToString(error));
+    }
+    return result;
+}
+
+/**
+ * @brief Discovery thread body. Uses a session of its own, as Awa sessions cannot be shared
+ *        between threads, so that registration polling overlaps with connect and definition
+ *        on the main session.
+ * @param *context pointer to DeviceDiscovery.
+ */
+static void *DeviceDiscoveryThread(void *context)
+{
+    DeviceDiscovery *discovery = context;
+
+    StartupProfile_Begin(StartupPhase_Discovery);
+    AwaServerSession *session = Server_EstablishSession(IPC_SERVER_PORT, IP_ADDRESS);
+    if (session != NULL)
+    {
+        discovery->registered = WaitForConstrainedDevices(session, &discovery->cancel);
+
+        if (AwaServerSession_Disconnect(session) != AwaError_Success)
+        {
+            LOG(LOG_WARN, "Failed to disconnect discovery session");
+        }
+        AwaServerSession_Free(&session);
+    }
+    if (discovery->registered)
+    {
+        StartupProfile_End(StartupPhase_Discovery);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Start waiting for constrained devices in the background.
+ * @param *discovery discovery state.
+ */
+static void StartDeviceDiscovery(DeviceDiscovery *discovery)
+{
+    discovery->started = false;
+    discovery->cancel = false;
+    discovery->registered = false;
+
+    if (pthread_create(&discovery->thread, NULL, DeviceDiscoveryThread, discovery) == 0)
+    {
+        discovery->started = true;
+    }
+    else
+    {
+        LOG(LOG_WARN, "Failed to start discovery thread, discovering after definition");
+    }
+}
+
+/**
+ * @brief Wait for device discovery to complete. If background discovery could not run or
+ *        failed, discovery is done on the given session instead.
+ * @param *discovery discovery state.
+ * @param *session main server session.
+ * @return true if all constrained devices registered, else false.
+ */
+static bool FinishDeviceDiscovery(DeviceDiscovery *discovery, const AwaServerSession *session)
+{
+    StartupProfile_Begin(StartupPhase_DiscoveryWait);
+    if (discovery->started)
+    {
+        pthread_join(discovery->thread, NULL);
+        discovery->started = false;
+    }
+
+    if (!discovery->registered && !g_quit)
+    {
+        StartupProfile_Begin(StartupPhase_Discovery);
+        discovery->registered = WaitForConstrainedDevices(session, &discovery->cancel);
+        if (discovery->registered)
+        {
+            StartupProfile_End(StartupPhase_Discovery);
+        }
+    }
+    if (discovery->registered)
+    {
+        StartupProfile_End(StartupPhase_DiscoveryWait);
+    }
+    return discovery->registered;
+}
+
+/**
+ * @brief Stop background discovery without waiting for devices.
+ * @param *discovery discovery state.
+ */
+static void CancelDeviceDiscovery(DeviceDiscovery *discovery)
+{
+    discovery->cancel = true;
+    if (discovery->started)
+    {
+        pthread_join(discovery->thread, NULL);
+        discovery->started = false;
+    }
+}
+
+/**
+ * @brief Reconnect a session, so that it fetches the server's current object definitions again.
+ * @param *session holds server session.
+ * @return true if the session is connected again, else false.
+ */
+static bool Server_RefreshSession(AwaServerSession *session)
+{
+    AwaServerSession_Disconnect(session);
+    if (AwaServerSession_Connect(session) != AwaError_Success)
+    {
+        LOG(LOG_ERR, "AwaServerSession_Connect() failed\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Observe the sensor, redefining objects and retrying if observation fails. The
+ *        server may have lost its definitions since the session fetched them, e.g. when
+ *        awa_serverd restarted, so the session is refreshed before each retry.
+ * @param *session holds server session.
+ * @param **observation set to the observation, to be kept until StopObservingSensor().
+ * @return true if observing sensor has been set successfully, else false.
+ */
+static bool ObserveSensor(AwaServerSession *session, AwaServerObservation **observation)
+{
+    unsigned int attempt;
+
+    for (attempt = 0; (attempt < OBSERVE_ATTEMPTS) && !g_quit; attempt++)
+    {
+        if (attempt != 0)
+        {
+            LOG(LOG_WARN, "Observation failed, redefining objects and retrying (%u/%u)", attempt, OBSERVE_ATTEMPTS - 1);
+            sleep(1 /*second*/);
+            if (!Server_RefreshSession(session) || !DefineServerObjects(session))
+            {
+                continue;
+            }
+        }
+
+        if (StartObservingSensor(session, observation))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Subscribe to client registration events. A server drops its observations of a client
+ *        that deregisters or registers again, so every registration of the sensor device has to
+ *        be observed again, however short the lapse was.
+ * @param *session holds server session.
+ * @return true if subscribed to both events, else false.
+ */
+static bool FollowSensorRegistration(AwaServerSession *session)
+{
+    if (AwaServerSession_SetClientRegisterEventCallback(session, ClientRegisterCallback, NULL) != AwaError_Success ||
+        AwaServerSession_SetClientDeregisterEventCallback(session, ClientDeregisterCallback, NULL) != AwaError_Success)
+    {
+        LOG(LOG_ERR, "Failed to subscribe to client registration events");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Make one attempt to observe the sensor again from the main loop. Unlike ObserveSensor(),
+ *        this does not retry, so that the caller can back off between attempts. An attempt that
+ *        follows a failed one reconnects and defines objects first, in case the server lost them.
+ * @param *session holds server session.
+ * @param **observation set to the observation, to be kept until StopObservingSensor().
+ * @param failures number of attempts that failed so far.
+ * @return true if observing sensor has been set successfully, else false.
+ */
+static bool ReobserveSensor(AwaServerSession *session, AwaServerObservation **observation, unsigned int failures)
+{
+    if (failures != 0 && (!Server_RefreshSession(session) || !DefineServerObjects(session)))
+    {
+        return false;
+    }
+    return StartObservingSensor(session, observation);
+}
+
+/**
+ * @brief Get the time to wait before the next attempt to observe again.
+ * @param failures number of attempts that failed so far.
+ * @return delay in nanoseconds, doubling from REOBSERVE_BACKOFF_MIN_MS up to REOBSERVE_BACKOFF_MAX_MS.
+ */
+static uint64_t ReobserveBackoffNs(unsigned int failures)
+{
+    uint64_t delayMs = REOBSERVE_BACKOFF_MIN_MS;
+
+    while (failures-- > 1 && delayMs < REOBSERVE_BACKOFF_MAX_MS)
+    {
+        delayMs *= 2;
+    }
+    return ((delayMs < REOBSERVE_BACKOFF_MAX_MS) ? delayMs : REOBSERVE_BACKOFF_MAX_MS) * NSEC_PER_MSEC;
+}
+
+/**
+ * @brief Get the time left until a deadline.
+ * @param deadlineNs monotonic deadline.
+ * @param now current monotonic time.
+ * @return time in milliseconds, rounded up.
+ */
+static unsigned int MsUntil(uint64_t deadlineNs, uint64_t now)
+{
+    return (deadlineNs > now) ? (unsigned int)((deadlineNs - now + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC) : 0;
+}
+
 /**
  * @brief Light controller application observes the IPSO resource for motion sensor on
  *        constrained device, and set the led on Ci40 board if any change observed.
  */
 int main(int argc, char **argv)
 {
-    int i, ret;
-    FILE *configFile;
+    int ret;
     const char *fptr = NULL;
-
-    ret = ParseCommandArgs(argc, argv, &fptr);
+    size_t logSize = DEFAULT_LOG_SIZE;
+    const char *ledRoot = LED_SYSFS_ROOT;
+    AwaServerObservation *observation = NULL;
+    unsigned int processFailures = 0;
+    unsigned int eventCapacity = DEFAULT_EVENT_CAPACITY;
+    unsigned long notifications = 0;
+    SensorEvent *event;
+    DeviceDiscovery discovery;
+
+    ret = ParseCommandArgs(argc, argv, &fptr, &logSize, &ledRoot, &eventCapacity);
     if (ret <= 0)
     {
         return ret;
     }
 
+    /* All steady state structures are sized here, before any notification arrives */
+    if (!Pool_Init(&g_eventPool, sizeof(SensorEvent), eventCapacity))
+    {
+        LOG(LOG_ERR, "Failed to create sensor event pool");
+        return -1;
+    }
+
     signal(SIGINT, CtrlCSignalHandler);
     signal(SIGTERM, CtrlCSignalHandler);
 
     if (fptr)
     {
-        configFile = fopen(fptr, "w");
-        if (configFile != NULL)
-        {
-            g_debugStream  = configFile;
-        }
-        else
+        if (!Log_OpenRing(fptr, logSize))
         {
             LOG(LOG_ERR, "Failed to create or open %s file", fptr);
         }
@@ -616,59 +1076,210 @@ int main(int argc, char **argv)
     LOG(LOG_INFO, "Light Controller Application");
     LOG(LOG_INFO, "------------------------\n");
 
+    Led_Open(&g_sensorLed, ledRoot, SENSOR_LED);
+    Led_Open(&g_heartbeatLed, ledRoot, HEARTBEAT_LED);
+
+    Led *transitionLeds[] = { &g_sensorLed };
+    Transition_Init(&g_transitions, g_outputs, transitionLeds, ARRAY_SIZE(g_outputs), FRAME_RATE, OnSensorRelease);
+
+    StartupProfile_Start();
+    StartDeviceDiscovery(&discovery);
+
+    /* Phases are only ended when they succeed, so that the report shows where start up stopped */
+    StartupProfile_Begin(StartupPhase_Session);
     serverSession = Server_EstablishSession(IPC_SERVER_PORT, IP_ADDRESS);
-    if (serverSession == NULL)
+    if (serverSession != NULL)
+    {
+        StartupProfile_End(StartupPhase_Session);
+    }
+    else
     {
         LOG(LOG_ERR, "Failed to establish server session\n");
     }
 
-    if (DefineServerObjects(serverSession))
+    bool observing = false;
+    StartupProfile_Begin(StartupPhase_Definition);
+    if (!DefineServerObjects(serverSession))
+    {
+        CancelDeviceDiscovery(&discovery);
+    }
+    else
     {
-        for (i = 0; i < ARRAY_SIZE(objects); i++)
+        StartupProfile_End(StartupPhase_Definition);
+        if (FinishDeviceDiscovery(&discovery, serverSession))
         {
-            LOG(LOG_INFO, "Waiting for constrained device '%s' to be up",objects[i].clientID);
-            while (CheckConstrainedRegistered(serverSession, objects[i].clientID) == false)
+            /* Subscribed before observing, so that no registration goes unnoticed */
+            FollowSensorRegistration(serverSession);
+            StartupProfile_Begin(StartupPhase_Observe);
+            observing = ObserveSensor(serverSession, &observation);
+            if (observing)
             {
-                sleep(1 /*second*/);
+                StartupProfile_End(StartupPhase_Observe);
+            }
+            else
+            {
+                LOG(LOG_ERR, "StartObservingSensor failed");
             }
         }
+    }
+    StartupProfile_Report();
 
-        if (StartObservingSensor(serverSession))
+    if (observing)
+    {
+        /* Found when libmotion_led_controller_alloccount.so is preloaded */
+        AllocCountFunction allocCount = (AllocCountFunction)dlsym(RTLD_DEFAULT, "AllocCount_Get");
+        unsigned long allocBase = (allocCount != NULL) ? allocCount() : 0;
+        AwaInteger cachedSensorState = g_sensorState;
+        bool heartbeatOn = false;
+        uint64_t heartbeatOffNs = 0;
+        uint64_t nextHeartbeatNs = 0;
+        uint64_t processRetryNs = 0;
+        bool reobserve = false;
+        uint64_t reobserveAtNs = 0;
+        unsigned int reobserveFailures = 0;
+
+        while(!g_quit)
         {
-            unsigned int cachedSensorState = g_sensorState;
-            while(!g_quit)
+            /* Light the heartbeat for HEARTBEAT_ON_MS once a second, however often frames wake the loop */
+            uint64_t now = Clock_NowNs();
+            if (heartbeatOn && now >= heartbeatOffNs)
             {
                 UpdateLed(false, true);
-                if (AwaServerSession_Process(serverSession, 1000 /* 1 second */) != AwaError_Success)
+                heartbeatOn = false;
+            }
+            if (now >= nextHeartbeatNs)
+            {
+                UpdateLed(true, true);
+                heartbeatOn = true;
+                heartbeatOffNs = now + HEARTBEAT_ON_MS * NSEC_PER_MSEC;
+                nextHeartbeatNs = now + HEARTBEAT_PERIOD_MS * NSEC_PER_MSEC;
+            }
+
+            /* Wake up for the next frame while the light is fading, else at the next deadline */
+            unsigned int idle = MsUntil(nextHeartbeatNs, now);
+            if (heartbeatOn && MsUntil(heartbeatOffNs, now) < idle)
+            {
+                idle = MsUntil(heartbeatOffNs, now);
+            }
+            if (reobserve && MsUntil(reobserveAtNs, now) < idle)
+            {
+                idle = MsUntil(reobserveAtNs, now);
+            }
+            if (now < processRetryNs && MsUntil(processRetryNs, now) < idle)
+            {
+                idle = MsUntil(processRetryNs, now);
+            }
+            unsigned int timeout = Transition_TimeoutMs(&g_transitions, now, idle);
+
+            /* After a failed process call wait without the session, so that fades carry on */
+            if (now < processRetryNs)
+            {
+                struct timespec wait = { timeout / 1000, (timeout % 1000) * NSEC_PER_MSEC };
+
+                nanosleep(&wait, NULL);
+                Transition_Frame(&g_transitions, Clock_NowNs());
+                continue;
+            }
+
+            TRACE(process_entry);
+            AwaError error = AwaServerSession_Process(serverSession, timeout);
+            TRACE1(process_exit, error);
+            if (error != AwaError_Success)
+            {
+                /* Ride out transient IPC errors, reconnect and observe again if they persist */
+                LOG(LOG_WARN, "AwaServerSession_Process() failed: %s", AwaError_ToString(error));
+                processRetryNs = Clock_NowNs() + PROCESS_RETRY_MS * NSEC_PER_MSEC;
+                if (++processFailures >= MAX_PROCESS_FAILURES)
                 {
-                    LOG(LOG_ERR, "AwaServerSession_Process() failed");
-                    break;
+                    LOG(LOG_ERR, "AwaServerSession_Process() failed %u times in a row, reconnecting", processFailures);
+                    processFailures = 0;
+                    StopObservingSensor(serverSession, &observation);
+                    Server_RefreshSession(serverSession);
+                    reobserve = true;
+                    reobserveAtNs = Clock_NowNs();
+                    reobserveFailures = 0;
                 }
-                AwaServerSession_DispatchCallbacks(serverSession);
+                Transition_Frame(&g_transitions, Clock_NowNs());
+                continue;
+            }
+            processFailures = 0;
+            TRACE(dispatch_entry);
+            AwaServerSession_DispatchCallbacks(serverSession);
+            TRACE(dispatch_exit);
 
-                /* Check if sensor state is changed */
-                if (g_sensorState != cachedSensorState)
+            /* Check if sensor state is changed */
+            while ((event = PopSensorEvent()) != NULL)
+            {
+                if (event->value != cachedSensorState)
                 {
+                    TRACE4(state_change, event->objectID, event->resourceID, event->value, event->timestampNs);
                     LOG(LOG_INFO, "Sensor state has changed");
-                    TurnOnLight();
-                    cachedSensorState = g_sensorState;
+                    TurnOnLight(Clock_NowNs());
+                    cachedSensorState = event->value;
                 }
-                UpdateLed(true, true);
+                Pool_Free(&g_eventPool, event);
+                notifications++;
+            }
+
+            /* Deregistration is handled first, the device may have registered again since */
+            if (g_sensorDeregistered)
+            {
+                g_sensorDeregistered = false;
+                StopObservingSensor(serverSession, &observation);
+                reobserve = false;
+            }
+            if (g_sensorRegistered)
+            {
+                g_sensorRegistered = false;
+                StopObservingSensor(serverSession, &observation);
+                reobserve = true;
+                reobserveAtNs = Clock_NowNs();
+                reobserveFailures = 0;
             }
+
+            now = Clock_NowNs();
+            if (reobserve && now >= reobserveAtNs)
+            {
+                if (ReobserveSensor(serverSession, &observation, reobserveFailures))
+                {
+                    LOG(LOG_INFO, "Observing sensor again");
+                    reobserve = false;
+                }
+                else
+                {
+                    reobserveFailures++;
+                    LOG(LOG_WARN, "Failed to observe sensor again, retrying in %llu ms",
+                            (unsigned long long)(ReobserveBackoffNs(reobserveFailures) / NSEC_PER_MSEC));
+                    reobserveAtNs = Clock_NowNs() + ReobserveBackoffNs(reobserveFailures);
+                }
+                now = Clock_NowNs();
+            }
+            Transition_Frame(&g_transitions, now);
         }
-        else
+
+        if (allocCount != NULL)
         {
-            LOG(LOG_ERR, "StartObservingSensor failed");
+            unsigned long allocations = allocCount() - allocBase;
+
+            LOG(LOG_INFO, "%lu heap allocations after start up, %lu per 100 notifications", allocations,
+                    (notifications != 0) ? allocations * 100 / notifications : 0);
         }
     }
 
+    if (g_quit)
+    {
+        LOG(LOG_INFO, "Exit triggered");
+    }
+
     /* Should never come here */
     UpdateLed(false, true);
+    UpdateLed(false, false);
+    Led_Close(&g_sensorLed);
+    Led_Close(&g_heartbeatLed);
+    StopObservingSensor(serverSession, &observation);
 
-    if (configFile)
-    {
-        fclose(configFile);
-    }
+    LOG(LOG_INFO, "Handled %lu notifications, %lu coalesced, event queue high water %u/%u",
+            notifications, g_coalescedEvents, g_eventPool.highWater, g_eventPool.capacity);
 
     if (AwaServerSession_Disconnect(serverSession) != AwaError_Success)
     {
@@ -680,7 +1291,16 @@ int main(int argc, char **argv)
         LOG(LOG_WARN, "Failed to free server session");
     }
 
+    while ((event = PopSensorEvent()) != NULL)
+    {
+        Pool_Free(&g_eventPool, event);
+    }
+    Pool_Destroy(&g_eventPool);
+
     LOG(LOG_INFO, "Light Controller Application Failure");
 
+    /* Closed last, as everything above may still log */
+    Log_CloseRing();
+
     return -1;
 }
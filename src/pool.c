@@ -0,0 +1,138 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file pool.c
+ * @brief Fixed-capacity pool of equally sized blocks.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+/** Alignment malloc() guarantees, which every block keeps so that it can hold any type. */
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#define POOL_ALIGNMENT (_Alignof(max_align_t))
+#else
+#define POOL_ALIGNMENT (__BIGGEST_ALIGNMENT__)
+#endif
+
+/** Round size up so that every block can hold a free list link and is suitably aligned. */
+#define POOL_ALIGN(size) (((size) + POOL_ALIGNMENT - 1) & ~(size_t)(POOL_ALIGNMENT - 1))
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+bool Pool_Init(Pool *pool, size_t blockSize, unsigned int capacity)
+{
+    unsigned int i;
+
+    if (pool == NULL || blockSize == 0 || capacity == 0)
+    {
+        return false;
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pool->blockSize = POOL_ALIGN(blockSize < sizeof(void *) ? sizeof(void *) : blockSize);
+    pool->capacity = capacity;
+
+    pool->storage = malloc(pool->blockSize * capacity);
+    if (pool->storage == NULL)
+    {
+        return false;
+    }
+
+    /* Chain blocks in address order so that allocation walks memory forwards */
+    for (i = capacity; i > 0; i--)
+    {
+        void **block = (void **)((char *)pool->storage + (i - 1) * pool->blockSize);
+        *block = pool->freeList;
+        pool->freeList = block;
+    }
+    return true;
+}
+
+void Pool_Destroy(Pool *pool)
+{
+    if (pool != NULL)
+    {
+        free(pool->storage);
+        pool->storage = NULL;
+        pool->freeList = NULL;
+        pool->used = 0;
+    }
+}
+
+void *Pool_Alloc(Pool *pool)
+{
+    void *block;
+
+    if (pool == NULL || pool->used >= pool->capacity)
+    {
+        return NULL;
+    }
+
+    block = pool->freeList;
+    if (block == NULL)
+    {
+        return NULL;
+    }
+    pool->freeList = *(void **)block;
+
+    pool->used++;
+    if (pool->used > pool->highWater)
+    {
+        pool->highWater = pool->used;
+    }
+    return block;
+}
+
+void Pool_Free(Pool *pool, void *block)
+{
+    if (pool == NULL || block == NULL)
+    {
+        return;
+    }
+
+    *(void **)block = pool->freeList;
+    pool->freeList = block;
+    pool->used--;
+}
@@ -0,0 +1,89 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file pool.h
+ * @brief Fixed-capacity pool of equally sized blocks.
+ *
+ * All blocks come from a single allocation made by Pool_Init(), so taking and returning blocks
+ * never reaches the heap.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A structure to contain pool state.
+ */
+typedef struct
+{
+    /*@{*/
+    size_t blockSize; /**< size of each block in bytes */
+    unsigned int capacity; /**< maximum number of blocks in use at once */
+    unsigned int used; /**< number of blocks currently in use */
+    unsigned int highWater; /**< largest number of blocks ever in use at once */
+    void *storage; /**< backing storage of all blocks */
+    void *freeList; /**< chain of free blocks */
+    /*@}*/
+}Pool;
+
+/**
+ * @brief Initialise a pool.
+ * @param *pool pool to initialise.
+ * @param blockSize size of each block in bytes.
+ * @param capacity maximum number of blocks, must be at least 1.
+ * @return true on success, else false.
+ */
+bool Pool_Init(Pool *pool, size_t blockSize, unsigned int capacity);
+
+/**
+ * @brief Release all storage held by a pool. Blocks still in use become invalid.
+ * @param *pool pool to destroy.
+ */
+void Pool_Destroy(Pool *pool);
+
+/**
+ * @brief Take a block from the pool.
+ * @param *pool pool to allocate from.
+ * @return pointer to the block, or NULL if the pool is exhausted.
+ */
+void *Pool_Alloc(Pool *pool);
+
+/**
+ * @brief Return a block to the pool.
+ * @param *pool pool the block was allocated from.
+ * @param *block block to return, may be NULL.
+ */
+void Pool_Free(Pool *pool, void *block);
+
+#endif  /* POOL_H */
@@ -0,0 +1,279 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file ring_log.c
+ * @brief Size-bounded log file kept as a memory mapped circular buffer.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ring_log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define ZERO_CHUNK_SIZE             (4096)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Round a size up to a power of two.
+ * @param size size to round, at most RING_LOG_MAX_SIZE.
+ * @return rounded size.
+ */
+static uint32_t RoundUpPowerOfTwo(size_t size)
+{
+    uint32_t result = RING_LOG_MIN_SIZE;
+
+    while (result < size)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+/**
+ * @brief Make a file exactly the given size, with all its blocks allocated.
+ * @param fd file to size.
+ * @param fileSize size in bytes.
+ * @return true on success, else false.
+ */
+static bool Preallocate(int fd, size_t fileSize)
+{
+    static const char zeros[ZERO_CHUNK_SIZE];
+    size_t offset;
+
+    if (ftruncate(fd, 0) != 0)
+    {
+        return false;
+    }
+
+    /* Reserve the blocks up front, so the log cannot fail for lack of space later */
+    int error = posix_fallocate(fd, 0, fileSize);
+    if (error == 0)
+    {
+        return true;
+    }
+    if (error != EOPNOTSUPP && error != EINVAL && error != ENOSYS)
+    {
+        return false;
+    }
+
+    /* Flash file systems such as UBIFS and JFFS2 cannot fallocate, and musl does not emulate it */
+    if (ftruncate(fd, fileSize) != 0)
+    {
+        return false;
+    }
+    for (offset = 0; offset < fileSize; offset += ZERO_CHUNK_SIZE)
+    {
+        size_t length = (fileSize - offset < ZERO_CHUNK_SIZE) ? fileSize - offset : ZERO_CHUNK_SIZE;
+
+        if (pwrite(fd, zeros, length, offset) != (ssize_t)length)
+        {
+            return false;
+        }
+    }
+    return fsync(fd) == 0;
+}
+
+/**
+ * @brief Copy bytes into the data area at a position, wrapping around at its end.
+ * @param *log ring log to write to.
+ * @param position position of the first byte.
+ * @param *data bytes to copy.
+ * @param length number of bytes, at most the data size.
+ */
+static void CopyIn(RingLog *log, uint32_t position, const char *data, size_t length)
+{
+    uint32_t size = log->header->size;
+    size_t offset = position & (size - 1);
+    size_t first = size - offset;
+
+    if (first >= length)
+    {
+        memcpy(log->data + offset, data, length);
+    }
+    else
+    {
+        memcpy(log->data + offset, data, first);
+        memcpy(log->data, data + first, length - first);
+    }
+}
+
+/**
+ * @brief Append bytes, publishing them only once they are completely in place. The caller holds
+ *        the lock.
+ * @param *log ring log to write to.
+ * @param *data bytes to append.
+ * @param length number of bytes, at most the data size.
+ */
+static void Append(RingLog *log, const char *data, size_t length)
+{
+    RingLogHeader *header = log->header;
+    uint32_t start = header->head;
+    uint32_t end = start + (uint32_t)length;
+
+    /* Mark the bytes about to be overwritten as lost before touching them */
+    if (!header->wrapped && (end > header->size || end < start))
+    {
+        header->wrapped = 1;
+    }
+    header->reserved = end;
+    __sync_synchronize();
+
+    CopyIn(log, start, data, length);
+
+    __sync_synchronize();
+    header->head = end;
+}
+
+bool RingLog_Open(RingLog *log, const char *path, size_t size)
+{
+    struct stat status;
+
+    log->header = NULL;
+    log->data = NULL;
+    log->mappedSize = 0;
+
+    if (size < RING_LOG_MIN_SIZE || size > RING_LOG_MAX_SIZE)
+    {
+        return false;
+    }
+    size = RoundUpPowerOfTwo(size);
+    size_t fileSize = RING_LOG_HEADER_SIZE + size;
+
+    log->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (log->fd < 0)
+    {
+        return false;
+    }
+
+    if (fstat(log->fd, &status) != 0 ||
+        ((size_t)status.st_size != fileSize && !Preallocate(log->fd, fileSize)))
+    {
+        close(log->fd);
+        return false;
+    }
+
+    void *mapping = mmap(NULL, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, log->fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close(log->fd);
+        return false;
+    }
+
+    pthread_mutex_init(&log->lock, NULL);
+    log->header = mapping;
+    log->data = (char *)mapping + RING_LOG_HEADER_SIZE;
+    log->mappedSize = fileSize;
+
+    RingLogHeader *header = log->header;
+
+    if (header->magic != RING_LOG_MAGIC || header->version != RING_LOG_VERSION ||
+        header->size != size || header->reserved - header->head > size)
+    {
+        memset(header, 0, RING_LOG_HEADER_SIZE);
+        header->size = size;
+        header->version = RING_LOG_VERSION;
+        __sync_synchronize();
+        header->magic = RING_LOG_MAGIC;
+    }
+    else if (header->reserved != header->head)
+    {
+        /* A write was cut short by a crash, blank out whatever part of it landed so it reads as a line */
+        uint32_t position;
+
+        for (position = header->head; position != header->reserved; position++)
+        {
+            log->data[position & (size - 1)] = (position + 1 == header->reserved) ? '\n' : ' ';
+        }
+        __sync_synchronize();
+        header->head = header->reserved;
+    }
+    return true;
+}
+
+void RingLog_Write(RingLog *log, const char *data, size_t length)
+{
+    if (log->header == NULL || length == 0)
+    {
+        return;
+    }
+
+    if (length > log->header->size)
+    {
+        data += length - log->header->size;
+        length = log->header->size;
+    }
+
+    pthread_mutex_lock(&log->lock);
+    Append(log, data, length);
+    pthread_mutex_unlock(&log->lock);
+}
+
+uint32_t RingLog_OldestRecord(const char *data, uint32_t size, uint32_t position, uint32_t head)
+{
+    while (position != head)
+    {
+        if (data[position++ & (size - 1)] == '\n')
+        {
+            return position;
+        }
+    }
+    return head;
+}
+
+void RingLog_Close(RingLog *log)
+{
+    if (log->header != NULL)
+    {
+        msync(log->header, log->mappedSize, MS_SYNC);
+        munmap(log->header, log->mappedSize);
+        log->header = NULL;
+        log->data = NULL;
+        close(log->fd);
+        pthread_mutex_destroy(&log->lock);
+    }
+}
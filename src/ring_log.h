@@ -0,0 +1,129 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file ring_log.h
+ * @brief Size-bounded log file kept as a memory mapped circular buffer.
+ *
+ * The file is a RingLogHeader followed by a data area whose size is a power of two. Records are
+ * appended to the data area with a memcpy, wrapping around at its end, so the file never grows,
+ * survives restarts without being truncated and, being a shared mapping, keeps everything written
+ * before a crash. Positions count every byte ever written, modulo 2^32, which the data size divides.
+ *
+ * A writer first moves reserved past the record, then copies it in, then moves head to reserved.
+ * Bytes before head are complete records, and bytes before reserved minus the data size may have
+ * been overwritten, so neither a crash in the middle of a write nor a reader running alongside the
+ * writer sees a half written record as a real one. Use motion_led_controller_logread to print the
+ * records in order.
+ */
+
+#ifndef RING_LOG_H
+#define RING_LOG_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//! \{
+#define RING_LOG_MAGIC              (0x524c434dU)   /* "MCLR" */
+#define RING_LOG_VERSION            (2)
+#define RING_LOG_HEADER_SIZE        (64)
+#define RING_LOG_MIN_SIZE           (4096)
+#define RING_LOG_MAX_SIZE           (0x80000000U)
+//! \}
+
+/**
+ * Header at the start of a ring log file. Positions are 32 bit so that they are read and written
+ * in one access on 32 bit targets.
+ */
+typedef struct
+{
+    /*@{*/
+    uint32_t magic; /**< RING_LOG_MAGIC */
+    uint32_t version; /**< RING_LOG_VERSION */
+    uint32_t size; /**< size of the data area in bytes, a power of two */
+    volatile uint32_t head; /**< position after the last complete record */
+    volatile uint32_t reserved; /**< position after the record being written, head when idle */
+    volatile uint32_t wrapped; /**< non zero once the data area has been written all the way round */
+    /*@}*/
+}RingLogHeader;
+
+/**
+ * A structure to contain an open ring log.
+ */
+typedef struct
+{
+    /*@{*/
+    int fd; /**< log file */
+    RingLogHeader *header; /**< mapping of the whole file, NULL if not open */
+    char *data; /**< data area within the mapping */
+    size_t mappedSize; /**< size of the mapping */
+    pthread_mutex_t lock; /**< serialises writers */
+    /*@}*/
+}RingLog;
+
+/**
+ * @brief Open a ring log for writing, creating and preallocating it if needed. An existing file
+ *        with the same data size is appended to; anything else is reinitialised.
+ * @param *log ring log to open.
+ * @param *path log file.
+ * @param size size of the data area in bytes, from RING_LOG_MIN_SIZE to RING_LOG_MAX_SIZE; it
+ *        is rounded up to a power of two.
+ * @return true on success, else false.
+ */
+bool RingLog_Open(RingLog *log, const char *path, size_t size);
+
+/**
+ * @brief Append a record. Safe to call from several threads at once, but not from signal handlers.
+ * @param *log ring log to write to.
+ * @param *data record bytes.
+ * @param length number of bytes; only the last size bytes of longer records are kept.
+ */
+void RingLog_Write(RingLog *log, const char *data, size_t length);
+
+/**
+ * @brief Find the first complete record once the bytes before a position are lost. The record
+ *        the position falls in is skipped, up to and including its newline.
+ * @param *data data area of the log.
+ * @param size size of the data area.
+ * @param position first position still held in the log.
+ * @param head position after the last complete record.
+ * @return position of the first complete record, head if there is none.
+ */
+uint32_t RingLog_OldestRecord(const char *data, uint32_t size, uint32_t position, uint32_t head);
+
+/**
+ * @brief Flush and close a ring log.
+ * @param *log ring log to close.
+ */
+void RingLog_Close(RingLog *log);
+
+#endif  /* RING_LOG_H */
@@ -0,0 +1,221 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file alloc_count.c
+ * @brief Heap allocation counter, preloaded with LD_PRELOAD. It interposes malloc, calloc, realloc,
+ *        posix_memalign, aligned_alloc and memalign for the whole process, so allocations made by
+ *        the libraries loaded into it are counted along with the controller's own. Preloaded into
+ *        motion_led_controller_appd, that includes libawa, and the controller logs the count on
+ *        exit. Preloaded into the soak binary, the Awa API is the in-process stand-in, so only the
+ *        controller and libc are measured. The count is read through AllocCount_Get(), looked up
+ *        at run time so that both binaries also run without the counter.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define BOOTSTRAP_SIZE              (4096)
+#define BOOTSTRAP_ALIGN             (16)
+//! @endcond
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/** Real malloc, from the next object in lookup order, normally libc. */
+static void *(*g_malloc)(size_t size);
+/** Real calloc. */
+static void *(*g_calloc)(size_t count, size_t size);
+/** Real realloc. */
+static void *(*g_realloc)(void *block, size_t size);
+/** Real free. */
+static void (*g_free)(void *block);
+/** Real posix_memalign. */
+static int (*g_posixMemalign)(void **block, size_t alignment, size_t size);
+/** Real aligned_alloc. */
+static void *(*g_alignedAlloc)(size_t alignment, size_t size);
+/** Real memalign. */
+static void *(*g_memalign)(size_t alignment, size_t size);
+
+/** Number of allocation calls so far. */
+static volatile unsigned long g_allocations = 0;
+
+/** Serves calloc calls that dlsym() makes while the real allocator is being looked up. */
+static char g_bootstrap[BOOTSTRAP_SIZE] __attribute__((aligned(BOOTSTRAP_ALIGN)));
+/** Bytes of g_bootstrap handed out. */
+static size_t g_bootstrapUsed = 0;
+/** Set while the real allocator is being looked up. */
+static volatile int g_resolving = 0;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Look up the real allocator functions on first use.
+ */
+static void Resolve(void)
+{
+    if (g_malloc != NULL)
+    {
+        return;
+    }
+    g_resolving = 1;
+    g_calloc = dlsym(RTLD_NEXT, "calloc");
+    g_realloc = dlsym(RTLD_NEXT, "realloc");
+    g_free = dlsym(RTLD_NEXT, "free");
+    g_posixMemalign = dlsym(RTLD_NEXT, "posix_memalign");
+    g_alignedAlloc = dlsym(RTLD_NEXT, "aligned_alloc");
+    g_memalign = dlsym(RTLD_NEXT, "memalign");
+    g_malloc = dlsym(RTLD_NEXT, "malloc");
+    g_resolving = 0;
+}
+
+/**
+ * @brief Hand out zeroed memory from the bootstrap buffer.
+ * @param size number of bytes.
+ * @return pointer to the memory, or NULL if the buffer is used up.
+ */
+static void *BootstrapAlloc(size_t size)
+{
+    size = (size + BOOTSTRAP_ALIGN - 1) & ~(size_t)(BOOTSTRAP_ALIGN - 1);
+    if (size > BOOTSTRAP_SIZE - g_bootstrapUsed)
+    {
+        return NULL;
+    }
+    void *block = &g_bootstrap[g_bootstrapUsed];
+    g_bootstrapUsed += size;
+    return block;
+}
+
+/**
+ * @brief Check whether a block came from the bootstrap buffer.
+ * @param *block block to check.
+ * @return true if it did, else false.
+ */
+static int IsBootstrap(const void *block)
+{
+    return (const char *)block >= g_bootstrap && (const char *)block < g_bootstrap + BOOTSTRAP_SIZE;
+}
+
+unsigned long AllocCount_Get(void)
+{
+    return g_allocations;
+}
+
+void *malloc(size_t size)
+{
+    if (g_resolving)
+    {
+        return BootstrapAlloc(size);
+    }
+    Resolve();
+    __sync_fetch_and_add(&g_allocations, 1);
+    return g_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    if (g_resolving)
+    {
+        /* The bootstrap buffer is static, so already zeroed */
+        return (size == 0 || count <= SIZE_MAX / size) ? BootstrapAlloc(count * size) : NULL;
+    }
+    Resolve();
+    __sync_fetch_and_add(&g_allocations, 1);
+    return g_calloc(count, size);
+}
+
+void *realloc(void *block, size_t size)
+{
+    Resolve();
+    __sync_fetch_and_add(&g_allocations, 1);
+    if (IsBootstrap(block))
+    {
+        /* Never resized in practice, move it out to the real heap */
+        void *moved = g_malloc(size);
+        if (moved != NULL)
+        {
+            char *to = moved;
+            const char *from = block;
+            size_t i;
+
+            for (i = 0; i < size && from + i < g_bootstrap + BOOTSTRAP_SIZE; i++)
+            {
+                to[i] = from[i];
+            }
+        }
+        return moved;
+    }
+    return g_realloc(block, size);
+}
+
+int posix_memalign(void **block, size_t alignment, size_t size)
+{
+    Resolve();
+    __sync_fetch_and_add(&g_allocations, 1);
+    return g_posixMemalign(block, alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    Resolve();
+    __sync_fetch_and_add(&g_allocations, 1);
+    return g_alignedAlloc(alignment, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    Resolve();
+    __sync_fetch_and_add(&g_allocations, 1);
+    return g_memalign(alignment, size);
+}
+
+void free(void *block)
+{
+    if (block == NULL || IsBootstrap(block))
+    {
+        return;
+    }
+    Resolve();
+    g_free(block);
+}
@@ -0,0 +1,1385 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file fake_awa.c
+ * @brief In-process stand-in for the parts of the AwaLWM2M server API used by the controller, for
+ *        soak testing without awa_serverd or a constrained device.
+ *
+ * The stand-in registers MotionSensorDevice immediately and generates a sensor notification with a
+ * new value every MLC_SOAK_INTERVAL_MS. At each AwaServerSession_Process() it checks whether the
+ * previous notification lit the sensor led in the fake sysfs tree (MLC_SOAK_LED); the time from
+ * delivery to that check is the actuation latency, as the controller handles a notification
+ * completely before processing again. Every
+ * MLC_SOAK_REPORT_S it prints an interval report to stderr with notification counts, missed
+ * actuations, actuation latency, resident memory and open file descriptors. After
+ * MLC_SOAK_DURATION_S it sends SIGTERM to the process and prints a summary and verdict on exit.
+ *
+ * When alloc_count.c is preloaded, reports also give the heap allocations made by the whole
+ * process during each interval. This stand-in replaces libawa, so they cover the controller and
+ * libc, not the allocations the real Awa API makes. The stand-in's own reporting is left
+ * out, and so are start up and shut down, as counting starts at the first process call and stops
+ * when SIGTERM is sent. Allocations made from a deregistration or a failed process call until the
+ * controller is back to normal are reported apart, as recovery allocations, and so are those made from listing the clients until
+ * the client iterator is freed, as poll allocations. The run fails if there are more than
+ * MLC_SOAK_ALLOC_LIMIT steady state allocations per 100 delivered notifications, 0 by default.
+ *
+ * Faults from fault.h are injected here for dropped notifications, IPC errors and device
+ * deregistration. Reconnections of the session after a failed process call are counted. A deregistered device drops out of the client list and sends nothing for
+ * MLC_SOAK_LAPSE_S, or for MLC_SOAK_SHORT_LAPSE_MS every other time, so that the device also comes
+ * back quicker than any polling would notice. Deregister and register events are dispatched to the
+ * callbacks set with AwaServerSession_SetClientDeregisterEventCallback() and
+ * AwaServerSession_SetClientRegisterEventCallback(). Like a real LWM2M server, the stand-in drops
+ * the observation when the device deregisters, so the controller has to observe again once the
+ * device is back. Notifications the
+ * device sends while it is not observed are reported as unobserved, and the run fails if observation
+ * is not back within MLC_SOAK_REOBSERVE_LIMIT_MS of the end of a lapse.
+ *
+ * Every MLC_SOAK_PAUSE_EVERY notifications the device goes quiet for MLC_SOAK_PAUSE_MS, long
+ * enough for the light to start fading out, so that the next notification interrupts the fade.
+ * Writes to the sensor led are seen through pwrite(), which the stand-in wraps. The run fails if
+ * a write does not change the brightness, or if the first write after interrupting a fade out
+ * halves it or takes it more than half way to full, by over 1/32 of max_brightness at once. A fade
+ * out whose last write was slowed by an injected fault is not checked, as the controller's level
+ * has moved on from what the led shows.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "awa/server.h"
+#include "clock.h"
+#include "fault.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define SOAK_CLIENT_ID              "MotionSensorDevice"
+#define MAX_DEFINED_OBJECTS         (16)
+#define SOAK_PATH_SIZE              (32)
+#define DEFAULT_INTERVAL_MS         (250)
+#define DEFAULT_DURATION_S          (60)
+#define DEFAULT_REPORT_S            (10)
+#define DEFAULT_LAPSE_S             (5)
+#define DEFAULT_SHORT_LAPSE_MS      (500)
+#define DEFAULT_RSS_LIMIT_KB        (256)
+#define DEFAULT_DRIFT_LIMIT_US      (100000)
+#define NSEC_PER_USEC               (1000ULL)
+#define DEFAULT_ALLOC_LIMIT         (0)
+#define DEFAULT_REOBSERVE_LIMIT_MS  (5000)
+#define DEFAULT_PAUSE_EVERY         (20)
+#define DEFAULT_PAUSE_MS            (5750)
+#define LED_LEVEL_SIZE              (16)
+#define LED_PATH_SIZE               (128)
+//! @endcond
+
+/***************************************************************************************************
+ * Typedef
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+struct _AwaServerSession
+{
+    bool connected;
+};
+
+struct _AwaChangeSet
+{
+    const AwaServerSession *session;
+    AwaInteger value;
+};
+
+struct _AwaServerObservation
+{
+    char clientID[SOAK_PATH_SIZE];
+    char path[SOAK_PATH_SIZE];
+    AwaServerObservationCallback callback;
+    void *context;
+};
+
+struct _AwaObjectDefinition
+{
+    AwaObjectID id;
+};
+
+struct _AwaServerDefineOperation
+{
+    AwaObjectID ids[MAX_DEFINED_OBJECTS];
+    unsigned int count;
+};
+
+struct _AwaServerListClientsOperation
+{
+    bool registered;
+};
+
+struct _AwaServerClientRegisterEvent
+{
+    int unused;
+};
+
+struct _AwaServerClientDeregisterEvent
+{
+    int unused;
+};
+
+struct _AwaClientIterator
+{
+    bool registered;
+    bool started;
+    bool listed;
+};
+
+struct _AwaServerObserveOperation
+{
+    AwaServerObservation *observation;
+    bool cancel;
+};
+
+struct _AwaServerObserveResponse
+{
+    int unused;
+};
+
+struct _AwaPathResult
+{
+    AwaError error;
+};
+//! @endcond
+
+/**
+ * A structure to contain statistics of one report interval.
+ */
+typedef struct
+{
+    /*@{*/
+    unsigned long generated; /**< notifications generated */
+    unsigned long dropped; /**< notifications lost before delivery */
+    unsigned long delivered; /**< notifications delivered to the controller */
+    unsigned long actuated; /**< delivered notifications that left the sensor led lit */
+    unsigned long missed; /**< delivered notifications that left the sensor led dark */
+    unsigned long ipcErrors; /**< failed process calls */
+    unsigned long reconnects; /**< session connections after the run started */
+    unsigned long deregistrations; /**< registration lapses */
+    unsigned long unobserved; /**< notifications sent while the device was not observed */
+    unsigned long reobservations; /**< observations set up again after a lapse */
+    uint64_t reobserveMaxNs; /**< longest time from the end of a lapse to observation */
+    unsigned long latencySamples; /**< number of latencies summed */
+    uint64_t latencySumNs; /**< sum of measured latencies */
+    uint64_t latencyMaxNs; /**< largest measured latency */
+    unsigned long allocations; /**< heap allocations made by the whole process in steady state */
+    unsigned long recoveryAllocations; /**< heap allocations made while recovering from a lapse */
+    unsigned long pollAllocations; /**< heap allocations made while listing the clients */
+    unsigned long ledWrites; /**< writes to the sensor led */
+    unsigned long redundantWrites; /**< sensor led writes that left the brightness as it was */
+    unsigned long interruptions; /**< notifications delivered while the sensor led faded out */
+    unsigned long jumps; /**< interrupted fades that made the brightness jump */
+    /*@}*/
+}SoakStats;
+
+/** Signature of AllocCount_Get() in the preloaded allocation counter. */
+typedef unsigned long (*AllocCountFunction)(void);
+
+/** Signature of pwrite(). */
+typedef ssize_t (*PwriteFunction)(int fd, const void *buffer, size_t count, off_t offset);
+
+/**
+ * A structure to contain state of the stand-in.
+ */
+typedef struct
+{
+    /*@{*/
+    bool started; /**< set on the first process call */
+    bool stopping; /**< SIGTERM has been sent */
+    const char *ledPath; /**< brightness attribute of the sensor led */
+    uint64_t intervalNs; /**< notification period */
+    uint64_t reportNs; /**< report period */
+    uint64_t lapseNs; /**< length of a registration lapse */
+    uint64_t shortLapseNs; /**< length of every other registration lapse */
+    unsigned long lapses; /**< registration lapses so far */
+    bool lapsed; /**< the device is away, or its return is not announced yet */
+    bool deregisterPending; /**< a deregister event waits for dispatch */
+    bool registerPending; /**< a register event waits for dispatch */
+    AwaServerClientRegisterEventCallback registerCallback; /**< register event callback, may be NULL */
+    void *registerContext; /**< context of registerCallback */
+    AwaServerClientDeregisterEventCallback deregisterCallback; /**< deregister event callback, may be NULL */
+    void *deregisterContext; /**< context of deregisterCallback */
+    uint64_t startNs; /**< time of the first process call */
+    uint64_t endNs; /**< time to stop */
+    uint64_t nextNotificationNs; /**< time of the next notification */
+    uint64_t nextReportNs; /**< time of the next report */
+    uint64_t deregisteredUntilNs; /**< end of the latest registration lapse, 0 if none yet */
+    bool awaitingReobserve; /**< a lapse dropped the observation and it is not back yet */
+    bool processFailed; /**< a process call failed and none has succeeded since */
+    bool reconnecting; /**< the session was disconnected and the sensor is not observed again yet */
+    AwaObjectID defined[MAX_DEFINED_OBJECTS]; /**< objects defined on the server */
+    unsigned int definedCount; /**< number of defined objects */
+    AwaServerObservation *observation; /**< active observation */
+    AwaChangeSet changeSet; /**< notification waiting for dispatch */
+    bool pending; /**< changeSet waits for dispatch */
+    bool awaitingCheck; /**< delivered notification waits for an actuation check */
+    uint64_t deliveredNs; /**< time of last delivery */
+    SoakStats interval; /**< statistics of the current report interval */
+    SoakStats total; /**< statistics of the whole run */
+    long firstRssKb; /**< resident memory at the first report */
+    long lastRssKb; /**< resident memory at the latest report */
+    int firstFds; /**< open descriptors at the first report */
+    int lastFds; /**< open descriptors at the latest report */
+    long firstLatencyUs; /**< mean latency of the first interval with samples, -1 if none */
+    long lastLatencyUs; /**< mean latency of the latest interval with samples, -1 if none */
+    AllocCountFunction allocCount; /**< allocation counter, NULL if it is not preloaded */
+    unsigned long allocBase; /**< allocation count at the start of the interval */
+    unsigned long allocStop; /**< allocation count when SIGTERM was sent */
+    unsigned long recoveryStart; /**< allocation count when the current recovery started */
+    unsigned long recoveryDone; /**< allocations made by finished recoveries */
+    unsigned long recoveryBase; /**< recovery allocations at the start of the interval */
+    bool polling; /**< the clients are listed and the iterator is not freed yet */
+    unsigned long pollStart; /**< allocation count when the current poll started */
+    unsigned long pollDone; /**< allocations made by finished polls */
+    unsigned long pollBase; /**< poll allocations at the start of the interval */
+    unsigned long pauseEvery; /**< notifications between pauses, 0 for none */
+    uint64_t pauseNs; /**< length of a pause */
+    unsigned long sincePause; /**< notifications generated since the last pause */
+    bool ledKnown; /**< ledDevice and ledInode identify the sensor led */
+    dev_t ledDevice; /**< device of the sensor led brightness attribute */
+    ino_t ledInode; /**< inode of the sensor led brightness attribute */
+    unsigned long ledMax; /**< max_brightness of the sensor led */
+    long ledLevel; /**< brightness last written to the sensor led, -1 if none yet */
+    bool ledFalling; /**< the last write dimmed the sensor led */
+    bool ledStalled; /**< a slow write was injected before the last write */
+    unsigned long ledSlowWrites; /**< injected slow writes at the last write */
+    bool interrupted; /**< a notification interrupted a fade out, its first write is not checked yet */
+    unsigned long interruptedLevel; /**< brightness when the fade out was interrupted */
+    /*@}*/
+}Soak;
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/** State of the stand-in. */
+static Soak g_soak =
+{
+    .firstRssKb = -1,
+    .firstFds = -1,
+    .firstLatencyUs = -1,
+    .lastLatencyUs = -1,
+    .ledLevel = -1,
+};
+
+/** The single path result returned by observe responses. */
+static AwaPathResult g_pathResult = { AwaError_Success };
+
+/** The single register event. */
+static AwaServerClientRegisterEvent g_registerEvent;
+
+/** The single deregister event. */
+static AwaServerClientDeregisterEvent g_deregisterEvent;
+
+/** The single observe response. */
+static AwaServerObserveResponse g_observeResponse;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Read an unsigned environment variable.
+ * @param *name variable name.
+ * @param defaultValue value if unset.
+ * @return value of the variable.
+ */
+static unsigned long GetEnv(const char *name, unsigned long defaultValue)
+{
+    const char *value = getenv(name);
+
+    return (value != NULL) ? strtoul(value, NULL, 0) : defaultValue;
+}
+
+/**
+ * @brief Read resident memory of this process.
+ * @return VmRSS in kilobytes, -1 if unavailable.
+ */
+static long ReadRssKb(void)
+{
+    char line[128];
+    long rss = -1;
+
+    FILE *file = fopen("/proc/self/status", "r");
+    if (file != NULL)
+    {
+        while (fgets(line, sizeof(line), file) != NULL)
+        {
+            if (sscanf(line, "VmRSS: %ld", &rss) == 1)
+            {
+                break;
+            }
+        }
+        fclose(file);
+    }
+    return rss;
+}
+
+/**
+ * @brief Count open file descriptors of this process, excluding the one used to count them.
+ * @return number of descriptors, -1 if unavailable.
+ */
+static int CountFds(void)
+{
+    struct dirent *entry;
+    int count = 0;
+
+    DIR *dir = opendir("/proc/self/fd");
+    if (dir == NULL)
+    {
+        return -1;
+    }
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] != '.')
+        {
+            count++;
+        }
+    }
+    closedir(dir);
+    return count - 1;
+}
+
+/**
+ * @brief Read the allocation count of the whole process, frozen once SIGTERM has been sent so
+ *        that shut down is not counted.
+ * @return number of allocations so far.
+ */
+static unsigned long AllocationsNow(void)
+{
+    return g_soak.stopping ? g_soak.allocStop : g_soak.allocCount();
+}
+
+/**
+ * @brief Check whether the controller is recovering from a lapse or a failed process call.
+ * @return true if it is not back to normal yet, else false.
+ */
+static bool IsRecovering(void)
+{
+    return g_soak.awaitingReobserve || g_soak.processFailed || g_soak.reconnecting;
+}
+
+/**
+ * @brief Set one of the recovery flags, starting or finishing the count of recovery allocations
+ *        when the controller starts or stops recovering.
+ * @param *flag awaitingReobserve, processFailed or reconnecting.
+ * @param value new value of the flag.
+ */
+static void SetRecovery(bool *flag, bool value)
+{
+    bool recovering = IsRecovering();
+
+    *flag = value;
+    if (g_soak.allocCount != NULL && !recovering && IsRecovering())
+    {
+        g_soak.recoveryStart = AllocationsNow();
+    }
+    else if (g_soak.allocCount != NULL && recovering && !IsRecovering())
+    {
+        g_soak.recoveryDone += AllocationsNow() - g_soak.recoveryStart;
+    }
+}
+
+/**
+ * @brief Read the number of allocations made while recovering from lapses and reconnections.
+ * @return number of allocations so far.
+ */
+static unsigned long RecoveryAllocationsNow(void)
+{
+    return g_soak.recoveryDone + (IsRecovering() ? AllocationsNow() - g_soak.recoveryStart : 0);
+}
+
+/**
+ * @brief Read the number of allocations made while listing the clients.
+ * @return number of allocations so far.
+ */
+static unsigned long PollAllocationsNow(void)
+{
+    return g_soak.pollDone + (g_soak.polling ? AllocationsNow() - g_soak.pollStart : 0);
+}
+
+/**
+ * @brief Add interval statistics to the totals.
+ * @param *total totals.
+ * @param *interval interval statistics.
+ */
+static void AccumulateStats(SoakStats *total, const SoakStats *interval)
+{
+    total->generated += interval->generated;
+    total->dropped += interval->dropped;
+    total->delivered += interval->delivered;
+    total->actuated += interval->actuated;
+    total->missed += interval->missed;
+    total->ipcErrors += interval->ipcErrors;
+    total->reconnects += interval->reconnects;
+    total->deregistrations += interval->deregistrations;
+    total->latencySamples += interval->latencySamples;
+    total->latencySumNs += interval->latencySumNs;
+    total->allocations += interval->allocations;
+    total->recoveryAllocations += interval->recoveryAllocations;
+    total->pollAllocations += interval->pollAllocations;
+    total->unobserved += interval->unobserved;
+    total->reobservations += interval->reobservations;
+    total->ledWrites += interval->ledWrites;
+    total->redundantWrites += interval->redundantWrites;
+    total->interruptions += interval->interruptions;
+    total->jumps += interval->jumps;
+    if (interval->reobserveMaxNs > total->reobserveMaxNs)
+    {
+        total->reobserveMaxNs = interval->reobserveMaxNs;
+    }
+    if (interval->latencyMaxNs > total->latencyMaxNs)
+    {
+        total->latencyMaxNs = interval->latencyMaxNs;
+    }
+}
+
+/**
+ * @brief Print the report of the interval that just ended and start a new one.
+ * @param now current monotonic time.
+ */
+static void Report(uint64_t now)
+{
+    SoakStats *stats = &g_soak.interval;
+    long meanUs = -1;
+
+    if (g_soak.allocCount != NULL)
+    {
+        stats->recoveryAllocations = RecoveryAllocationsNow() - g_soak.recoveryBase;
+        stats->pollAllocations = PollAllocationsNow() - g_soak.pollBase;
+        stats->allocations = AllocationsNow() - g_soak.allocBase - stats->recoveryAllocations - stats->pollAllocations;
+    }
+
+    g_soak.lastRssKb = ReadRssKb();
+    g_soak.lastFds = CountFds();
+    if (g_soak.firstRssKb < 0)
+    {
+        g_soak.firstRssKb = g_soak.lastRssKb;
+        g_soak.firstFds = g_soak.lastFds;
+    }
+
+    if (stats->latencySamples != 0)
+    {
+        meanUs = stats->latencySumNs / stats->latencySamples / NSEC_PER_USEC;
+        if (g_soak.firstLatencyUs < 0)
+        {
+            g_soak.firstLatencyUs = meanUs;
+        }
+        g_soak.lastLatencyUs = meanUs;
+    }
+
+    fprintf(stderr, "soak: t=%llus generated=%lu dropped=%lu delivered=%lu actuated=%lu missed=%lu "
+            "latency_mean_us=%ld latency_max_us=%llu ipc_errors=%lu reconnects=%lu deregistrations=%lu "
+            "unobserved=%lu reobserve_max_ms=%llu led_writes=%lu redundant_writes=%lu interruptions=%lu "
+            "jumps=%lu rss_kb=%ld fds=%d allocs=%ld recovery_allocs=%ld poll_allocs=%ld\n",
+            (unsigned long long)((now - g_soak.startNs) / NSEC_PER_SEC),
+            stats->generated, stats->dropped, stats->delivered, stats->actuated, stats->missed,
+            meanUs, (unsigned long long)(stats->latencyMaxNs / NSEC_PER_USEC),
+            stats->ipcErrors, stats->reconnects, stats->deregistrations, stats->unobserved,
+            (unsigned long long)(stats->reobserveMaxNs / NSEC_PER_MSEC), stats->ledWrites, stats->redundantWrites,
+            stats->interruptions, stats->jumps, g_soak.lastRssKb, g_soak.lastFds,
+            (g_soak.allocCount != NULL) ? (long)stats->allocations : -1L,
+            (g_soak.allocCount != NULL) ? (long)stats->recoveryAllocations : -1L,
+            (g_soak.allocCount != NULL) ? (long)stats->pollAllocations : -1L);
+
+    AccumulateStats(&g_soak.total, stats);
+    memset(stats, 0, sizeof(*stats));
+
+    /* Allocations made to produce this report are not counted */
+    if (g_soak.allocCount != NULL)
+    {
+        g_soak.allocBase = AllocationsNow();
+        g_soak.recoveryBase = RecoveryAllocationsNow();
+        g_soak.pollBase = PollAllocationsNow();
+    }
+}
+
+/**
+ * @brief Print the summary and verdict of the run.
+ */
+static void Summary(void)
+{
+    SoakStats *total = &g_soak.total;
+    long rssGrowth = g_soak.lastRssKb - g_soak.firstRssKb;
+    int fdGrowth = g_soak.lastFds - g_soak.firstFds;
+    long drift = (g_soak.firstLatencyUs >= 0) ? g_soak.lastLatencyUs - g_soak.firstLatencyUs : 0;
+    unsigned long ledFaults = Fault_Count(Fault_LedFail);
+    uint64_t reobserveLimitNs = GetEnv("MLC_SOAK_REOBSERVE_LIMIT_MS", DEFAULT_REOBSERVE_LIMIT_MS) * NSEC_PER_MSEC;
+    bool pass = true;
+
+    Report(Clock_NowNs());
+
+    fprintf(stderr, "soak: total generated=%lu dropped=%lu delivered=%lu actuated=%lu missed=%lu "
+            "led_faults=%lu slow_writes=%lu ipc_errors=%lu reconnects=%lu deregistrations=%lu unobserved=%lu "
+            "reobservations=%lu\n",
+            total->generated, total->dropped, total->delivered, total->actuated, total->missed,
+            ledFaults, Fault_Count(Fault_LedSlow), total->ipcErrors, total->reconnects, total->deregistrations,
+            total->unobserved, total->reobservations);
+    fprintf(stderr, "soak: led_writes=%lu redundant_writes=%lu interruptions=%lu jumps=%lu\n",
+            total->ledWrites, total->redundantWrites, total->interruptions, total->jumps);
+    fprintf(stderr, "soak: rss_growth_kb=%ld fd_growth=%d latency_drift_us=%ld latency_max_us=%llu\n",
+            rssGrowth, fdGrowth, drift, (unsigned long long)(total->latencyMaxNs / NSEC_PER_USEC));
+    if (g_soak.allocCount != NULL)
+    {
+        fprintf(stderr, "soak: allocs=%lu allocs_per_100_notifications=%lu recovery_allocs=%lu poll_allocs=%lu\n",
+                total->allocations, (total->delivered != 0) ? total->allocations * 100 / total->delivered : 0,
+                total->recoveryAllocations, total->pollAllocations);
+    }
+    else
+    {
+        fprintf(stderr, "soak: allocs not counted, preload libmotion_led_controller_alloccount.so\n");
+    }
+
+    /* Every injected led failure may cost at most one actuation */
+    if (total->missed > ledFaults)
+    {
+        fprintf(stderr, "soak: %lu missed actuations not explained by injected led faults\n", total->missed - ledFaults);
+        pass = false;
+    }
+    if (total->delivered == 0)
+    {
+        fprintf(stderr, "soak: no notifications delivered\n");
+        pass = false;
+    }
+    if (rssGrowth > (long)GetEnv("MLC_SOAK_RSS_LIMIT_KB", DEFAULT_RSS_LIMIT_KB))
+    {
+        fprintf(stderr, "soak: resident memory grew by %ld kB\n", rssGrowth);
+        pass = false;
+    }
+    if (fdGrowth > 0)
+    {
+        fprintf(stderr, "soak: %d file descriptors leaked\n", fdGrowth);
+        pass = false;
+    }
+    if (drift > (long)GetEnv("MLC_SOAK_DRIFT_LIMIT_US", DEFAULT_DRIFT_LIMIT_US))
+    {
+        fprintf(stderr, "soak: actuation latency drifted by %ld us\n", drift);
+        pass = false;
+    }
+    if (g_soak.allocCount != NULL && total->delivered != 0 &&
+        total->allocations * 100 / total->delivered > GetEnv("MLC_SOAK_ALLOC_LIMIT", DEFAULT_ALLOC_LIMIT))
+    {
+        fprintf(stderr, "soak: %lu heap allocations in steady state\n", total->allocations);
+        pass = false;
+    }
+    if (total->reobserveMaxNs > reobserveLimitNs)
+    {
+        fprintf(stderr, "soak: observation took %llu ms to come back after a lapse\n",
+                (unsigned long long)(total->reobserveMaxNs / NSEC_PER_MSEC));
+        pass = false;
+    }
+    if (g_soak.awaitingReobserve && g_soak.endNs > g_soak.deregisteredUntilNs + reobserveLimitNs)
+    {
+        fprintf(stderr, "soak: observation never came back after the last lapse\n");
+        pass = false;
+    }
+    if (total->redundantWrites != 0)
+    {
+        fprintf(stderr, "soak: %lu led writes did not change the brightness\n", total->redundantWrites);
+        pass = false;
+    }
+    if (total->jumps != 0)
+    {
+        fprintf(stderr, "soak: %lu interrupted fades made the led jump\n", total->jumps);
+        pass = false;
+    }
+    fprintf(stderr, "soak: verdict %s\n", pass ? "PASS" : "FAIL");
+}
+
+/**
+ * @brief Identify the sensor led brightness attribute, so that writes to it can be told apart, and
+ *        read its max_brightness.
+ */
+static void OpenSensorLed(void)
+{
+    char path[LED_PATH_SIZE];
+    struct stat status;
+    const char *slash;
+
+    if (g_soak.ledPath == NULL || stat(g_soak.ledPath, &status) != 0)
+    {
+        return;
+    }
+    g_soak.ledDevice = status.st_dev;
+    g_soak.ledInode = status.st_ino;
+
+    g_soak.ledMax = 1;
+    slash = strrchr(g_soak.ledPath, '/');
+    if (slash != NULL)
+    {
+        snprintf(path, sizeof(path), "%.*s/max_brightness", (int)(slash - g_soak.ledPath), g_soak.ledPath);
+        FILE *file = fopen(path, "r");
+        if (file != NULL)
+        {
+            if (fscanf(file, "%lu", &g_soak.ledMax) != 1 || g_soak.ledMax == 0)
+            {
+                g_soak.ledMax = 1;
+            }
+            fclose(file);
+        }
+    }
+    g_soak.ledKnown = true;
+}
+
+/**
+ * @brief Check a write to the sensor led. Shut down, which turns the led off unconditionally, is
+ *        not checked.
+ * @param level brightness written.
+ */
+static void CheckLedWrite(unsigned long level)
+{
+    if (g_soak.stopping)
+    {
+        return;
+    }
+
+    g_soak.interval.ledWrites++;
+    if (g_soak.ledLevel >= 0 && level == (unsigned long)g_soak.ledLevel)
+    {
+        g_soak.interval.redundantWrites++;
+    }
+    if (g_soak.interrupted)
+    {
+        /* The fade in must carry on from where the fade out was, not restart from dark or snap to full */
+        unsigned long from = g_soak.interruptedLevel;
+        unsigned long step = (level > from) ? level - from : from - level;
+
+        g_soak.interrupted = false;
+        if (step > g_soak.ledMax / 32 &&
+            ((level < from && level < from / 2) || (level > from && step > (g_soak.ledMax - from + 1) / 2)))
+        {
+            g_soak.interval.jumps++;
+        }
+    }
+    g_soak.ledFalling = g_soak.ledLevel >= 0 && level < (unsigned long)g_soak.ledLevel;
+    g_soak.ledLevel = (long)level;
+    g_soak.ledStalled = Fault_Count(Fault_LedSlow) != g_soak.ledSlowWrites;
+    g_soak.ledSlowWrites = Fault_Count(Fault_LedSlow);
+}
+
+/**
+ * @brief Start the run on the first process call, once the controller is in steady state.
+ * @param now current monotonic time.
+ */
+static void StartSoak(uint64_t now)
+{
+    g_soak.started = true;
+    g_soak.ledPath = getenv("MLC_SOAK_LED");
+    g_soak.intervalNs = GetEnv("MLC_SOAK_INTERVAL_MS", DEFAULT_INTERVAL_MS) * NSEC_PER_MSEC;
+    g_soak.reportNs = GetEnv("MLC_SOAK_REPORT_S", DEFAULT_REPORT_S) * NSEC_PER_SEC;
+    g_soak.lapseNs = GetEnv("MLC_SOAK_LAPSE_S", DEFAULT_LAPSE_S) * NSEC_PER_SEC;
+    g_soak.shortLapseNs = GetEnv("MLC_SOAK_SHORT_LAPSE_MS", DEFAULT_SHORT_LAPSE_MS) * NSEC_PER_MSEC;
+    g_soak.startNs = now;
+    g_soak.endNs = now + GetEnv("MLC_SOAK_DURATION_S", DEFAULT_DURATION_S) * NSEC_PER_SEC;
+    g_soak.nextNotificationNs = now + g_soak.intervalNs;
+    g_soak.nextReportNs = now + g_soak.reportNs;
+    g_soak.pauseEvery = GetEnv("MLC_SOAK_PAUSE_EVERY", DEFAULT_PAUSE_EVERY);
+    g_soak.pauseNs = GetEnv("MLC_SOAK_PAUSE_MS", DEFAULT_PAUSE_MS) * NSEC_PER_MSEC;
+    OpenSensorLed();
+
+    if (g_soak.intervalNs == 0 || g_soak.reportNs == 0)
+    {
+        fprintf(stderr, "soak: MLC_SOAK_INTERVAL_MS and MLC_SOAK_REPORT_S must be non zero\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Steady state allocations are counted from here on */
+    g_soak.allocCount = (AllocCountFunction)dlsym(RTLD_DEFAULT, "AllocCount_Get");
+    if (g_soak.allocCount != NULL)
+    {
+        g_soak.allocBase = g_soak.allocCount();
+    }
+
+    Report(now);
+    atexit(Summary);
+}
+
+/**
+ * @brief Check whether the last delivered notification left the sensor led lit.
+ * @param now current monotonic time.
+ */
+static void CheckActuation(uint64_t now)
+{
+    char level[16] = {0};
+
+    if (!g_soak.awaitingCheck)
+    {
+        return;
+    }
+    g_soak.awaitingCheck = false;
+
+    int fd = (g_soak.ledPath != NULL) ? open(g_soak.ledPath, O_RDONLY) : -1;
+    if (fd < 0)
+    {
+        g_soak.interval.missed++;
+        return;
+    }
+
+    if (read(fd, level, sizeof(level) - 1) > 0 && strtoul(level, NULL, 0) != 0)
+    {
+        uint64_t latency = now - g_soak.deliveredNs;
+
+        g_soak.interval.actuated++;
+        g_soak.interval.latencySamples++;
+        g_soak.interval.latencySumNs += latency;
+        if (latency > g_soak.interval.latencyMaxNs)
+        {
+            g_soak.interval.latencyMaxNs = latency;
+        }
+    }
+    else
+    {
+        g_soak.interval.missed++;
+    }
+    close(fd);
+}
+
+/**
+ * @brief Check whether the constrained device is currently registered.
+ * @return true if registered, else false.
+ */
+static bool IsRegistered(void)
+{
+    return g_soak.deregisteredUntilNs == 0 || Clock_NowNs() >= g_soak.deregisteredUntilNs;
+}
+
+/**
+ * @brief Extract the object ID from a resource path of the form /object/instance/resource.
+ * @param *path resource path.
+ * @return object ID.
+ */
+static AwaObjectID ObjectFromPath(const char *path)
+{
+    return (AwaObjectID)strtol(path + 1, NULL, 10);
+}
+
+const char *AwaError_ToString(AwaError error)
+{
+    switch (error)
+    {
+        case AwaError_Success:
+            return "AwaError_Success";
+        case AwaError_IPCError:
+            return "AwaError_IPCError";
+        default:
+            return "AwaError_Unspecified";
+    }
+}
+
+AwaError AwaAPI_MakeResourcePath(char *path, size_t pathSize, AwaObjectID objectID, AwaObjectInstanceID objectInstanceID, AwaResourceID resourceID)
+{
+    int length = snprintf(path, pathSize, "/%d/%d/%d", objectID, objectInstanceID, resourceID);
+
+    return (length > 0 && (size_t)length < pathSize) ? AwaError_Success : AwaError_Unspecified;
+}
+
+AwaServerSession *AwaServerSession_New(void)
+{
+    return calloc(1, sizeof(AwaServerSession));
+}
+
+AwaError AwaServerSession_SetIPCAsUDP(AwaServerSession *session, const char *address, unsigned short port)
+{
+    return (session != NULL) ? AwaError_Success : AwaError_Unspecified;
+}
+
+AwaError AwaServerSession_Connect(AwaServerSession *session)
+{
+    if (session == NULL)
+    {
+        return AwaError_Unspecified;
+    }
+    session->connected = true;
+    if (g_soak.started)
+    {
+        g_soak.interval.reconnects++;
+    }
+    return AwaError_Success;
+}
+
+AwaError AwaServerSession_Disconnect(AwaServerSession *session)
+{
+    if (session == NULL || !session->connected)
+    {
+        return AwaError_Unspecified;
+    }
+    session->connected = false;
+    if (g_soak.started && !g_soak.stopping)
+    {
+        SetRecovery(&g_soak.reconnecting, true);
+    }
+    return AwaError_Success;
+}
+
+AwaError AwaServerSession_Free(AwaServerSession **session)
+{
+    if (session == NULL || *session == NULL)
+    {
+        return AwaError_Unspecified;
+    }
+    free(*session);
+    *session = NULL;
+    return AwaError_Success;
+}
+
+bool AwaServerSession_IsObjectDefined(const AwaServerSession *session, AwaObjectID objectID)
+{
+    unsigned int i;
+
+    for (i = 0; i < g_soak.definedCount; i++)
+    {
+        if (g_soak.defined[i] == objectID)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+AwaError AwaServerSession_Process(AwaServerSession *session, AwaTimeout timeout)
+{
+    struct timespec wake;
+    uint64_t now = Clock_NowNs();
+
+    if (!g_soak.started)
+    {
+        StartSoak(now);
+    }
+
+    CheckActuation(now);
+
+    if (now >= g_soak.endNs)
+    {
+        if (!g_soak.stopping)
+        {
+            if (g_soak.allocCount != NULL)
+            {
+                g_soak.allocStop = g_soak.allocCount();
+            }
+            g_soak.stopping = true;
+            raise(SIGTERM);
+        }
+        return AwaError_Success;
+    }
+
+    if (Fault_Inject(Fault_IPCError))
+    {
+        g_soak.interval.ipcErrors++;
+        SetRecovery(&g_soak.processFailed, true);
+        return AwaError_IPCError;
+    }
+    SetRecovery(&g_soak.processFailed, false);
+
+    if (IsRegistered() && Fault_Inject(Fault_Deregister))
+    {
+        g_soak.deregisteredUntilNs = now + ((g_soak.lapses++ % 2 != 0) ? g_soak.shortLapseNs : g_soak.lapseNs);
+        g_soak.interval.deregistrations++;
+        g_soak.lapsed = true;
+        g_soak.deregisterPending = true;
+        g_soak.registerPending = false;
+
+        /* The server forgets the observation, as a real one does when a client deregisters */
+        g_soak.observation = NULL;
+        g_soak.pending = false;
+        SetRecovery(&g_soak.awaitingReobserve, true);
+    }
+
+    uint64_t wakeNs = now + (uint64_t)timeout * NSEC_PER_MSEC;
+    if (g_soak.nextNotificationNs < wakeNs)
+    {
+        wakeNs = g_soak.nextNotificationNs;
+    }
+    if (g_soak.nextReportNs < wakeNs)
+    {
+        wakeNs = g_soak.nextReportNs;
+    }
+    if (g_soak.endNs < wakeNs)
+    {
+        wakeNs = g_soak.endNs;
+    }
+    if (g_soak.lapsed && g_soak.deregisteredUntilNs < wakeNs)
+    {
+        wakeNs = g_soak.deregisteredUntilNs;
+    }
+
+    wake.tv_sec = wakeNs / NSEC_PER_SEC;
+    wake.tv_nsec = wakeNs % NSEC_PER_SEC;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR)
+    {
+        if (Clock_NowNs() >= g_soak.endNs)
+        {
+            break;
+        }
+    }
+    now = Clock_NowNs();
+
+    if (g_soak.lapsed && IsRegistered())
+    {
+        g_soak.lapsed = false;
+        g_soak.registerPending = true;
+    }
+
+    if (now >= g_soak.nextNotificationNs)
+    {
+        g_soak.nextNotificationNs += g_soak.intervalNs;
+        if (g_soak.pauseEvery != 0 && ++g_soak.sincePause >= g_soak.pauseEvery)
+        {
+            g_soak.sincePause = 0;
+            g_soak.nextNotificationNs += g_soak.pauseNs - g_soak.intervalNs;
+        }
+
+        /* A device that is away sends nothing */
+        if (IsRegistered())
+        {
+            g_soak.interval.generated++;
+            g_soak.changeSet.value++;
+
+            if (Fault_Inject(Fault_DropNotification))
+            {
+                g_soak.interval.dropped++;
+            }
+            else if (g_soak.observation != NULL)
+            {
+                g_soak.changeSet.session = session;
+                g_soak.pending = true;
+            }
+            else
+            {
+                g_soak.interval.unobserved++;
+            }
+        }
+    }
+
+    if (now >= g_soak.nextReportNs)
+    {
+        g_soak.nextReportNs += g_soak.reportNs;
+        Report(now);
+    }
+    return AwaError_Success;
+}
+
+/**
+ * @brief Wraps pwrite() of the C library to see every write to the sensor led. Anything else is
+ *        passed through untouched.
+ */
+ssize_t pwrite(int fd, const void *buffer, size_t count, off_t offset)
+{
+    static PwriteFunction next = NULL;
+    char level[LED_LEVEL_SIZE];
+    struct stat status;
+
+    if (next == NULL)
+    {
+        next = (PwriteFunction)dlsym(RTLD_NEXT, "pwrite");
+    }
+
+    ssize_t result = next(fd, buffer, count, offset);
+    if (result > 0 && g_soak.ledKnown && fstat(fd, &status) == 0 &&
+        status.st_dev == g_soak.ledDevice && status.st_ino == g_soak.ledInode)
+    {
+        size_t length = ((size_t)result < sizeof(level) - 1) ? (size_t)result : sizeof(level) - 1;
+
+        memcpy(level, buffer, length);
+        level[length] = '\0';
+        CheckLedWrite(strtoul(level, NULL, 10));
+    }
+    return result;
+}
+
+AwaError AwaServerSession_SetClientRegisterEventCallback(AwaServerSession *session, AwaServerClientRegisterEventCallback callback, void *context)
+{
+    g_soak.registerCallback = callback;
+    g_soak.registerContext = context;
+    return AwaError_Success;
+}
+
+AwaError AwaServerSession_SetClientDeregisterEventCallback(AwaServerSession *session, AwaServerClientDeregisterEventCallback callback, void *context)
+{
+    g_soak.deregisterCallback = callback;
+    g_soak.deregisterContext = context;
+    return AwaError_Success;
+}
+
+AwaClientIterator *AwaServerClientRegisterEvent_NewClientIterator(const AwaServerClientRegisterEvent *event)
+{
+    AwaClientIterator *iterator = calloc(1, sizeof(AwaClientIterator));
+
+    if (iterator != NULL)
+    {
+        iterator->registered = true;
+    }
+    return iterator;
+}
+
+AwaClientIterator *AwaServerClientDeregisterEvent_NewClientIterator(const AwaServerClientDeregisterEvent *event)
+{
+    AwaClientIterator *iterator = calloc(1, sizeof(AwaClientIterator));
+
+    if (iterator != NULL)
+    {
+        iterator->registered = true;
+    }
+    return iterator;
+}
+
+AwaError AwaServerSession_DispatchCallbacks(AwaServerSession *session)
+{
+    /* Events come in the order they happened, a device that is back has been away first */
+    if (g_soak.deregisterPending)
+    {
+        g_soak.deregisterPending = false;
+        if (g_soak.deregisterCallback != NULL)
+        {
+            g_soak.deregisterCallback(&g_deregisterEvent, g_soak.deregisterContext);
+        }
+    }
+    if (g_soak.registerPending)
+    {
+        g_soak.registerPending = false;
+        if (g_soak.registerCallback != NULL)
+        {
+            g_soak.registerCallback(&g_registerEvent, g_soak.registerContext);
+        }
+    }
+
+    if (g_soak.pending && g_soak.observation != NULL)
+    {
+        g_soak.pending = false;
+        g_soak.awaitingCheck = true;
+        g_soak.interval.delivered++;
+        g_soak.deliveredNs = Clock_NowNs();
+        /* Notifications delivered before the led is written again interrupt the same fade */
+        if (!g_soak.interrupted && g_soak.ledFalling && g_soak.ledLevel > 0 && !g_soak.ledStalled)
+        {
+            g_soak.interval.interruptions++;
+            g_soak.interrupted = true;
+            g_soak.interruptedLevel = (unsigned long)g_soak.ledLevel;
+        }
+        g_soak.observation->callback(&g_soak.changeSet, g_soak.observation->context);
+    }
+    return AwaError_Success;
+}
+
+AwaObjectDefinition *AwaObjectDefinition_New(AwaObjectID objectID, const char *objectName, int minimumInstances, int maximumInstances)
+{
+    AwaObjectDefinition *definition = calloc(1, sizeof(AwaObjectDefinition));
+
+    if (definition != NULL)
+    {
+        definition->id = objectID;
+    }
+    return definition;
+}
+
+void AwaObjectDefinition_Free(AwaObjectDefinition **objectDefinition)
+{
+    if (objectDefinition != NULL)
+    {
+        free(*objectDefinition);
+        *objectDefinition = NULL;
+    }
+}
+
+AwaError AwaObjectDefinition_AddResourceDefinitionAsInteger(AwaObjectDefinition *objectDefinition, AwaResourceID resourceID,
+    const char *resourceName, bool isMandatory, AwaResourceOperations operations, AwaInteger defaultValue)
+{
+    return (objectDefinition != NULL) ? AwaError_Success : AwaError_Unspecified;
+}
+
+AwaError AwaObjectDefinition_AddResourceDefinitionAsBoolean(AwaObjectDefinition *objectDefinition, AwaResourceID resourceID,
+    const char *resourceName, bool isMandatory, AwaResourceOperations operations, AwaBoolean defaultValue)
+{
+    return (objectDefinition != NULL) ? AwaError_Success : AwaError_Unspecified;
+}
+
+AwaServerDefineOperation *AwaServerDefineOperation_New(const AwaServerSession *session)
+{
+    return calloc(1, sizeof(AwaServerDefineOperation));
+}
+
+AwaError AwaServerDefineOperation_Add(AwaServerDefineOperation *operation, const AwaObjectDefinition *objectDefinition)
+{
+    if (operation == NULL || objectDefinition == NULL || operation->count >= MAX_DEFINED_OBJECTS)
+    {
+        return AwaError_Unspecified;
+    }
+    operation->ids[operation->count++] = objectDefinition->id;
+    return AwaError_Success;
+}
+
+AwaError AwaServerDefineOperation_Perform(AwaServerDefineOperation *operation, AwaTimeout timeout)
+{
+    unsigned int i;
+
+    for (i = 0; i < operation->count && g_soak.definedCount < MAX_DEFINED_OBJECTS; i++)
+    {
+        if (!AwaServerSession_IsObjectDefined(NULL, operation->ids[i]))
+        {
+            g_soak.defined[g_soak.definedCount++] = operation->ids[i];
+        }
+    }
+    return AwaError_Success;
+}
+
+AwaError AwaServerDefineOperation_Free(AwaServerDefineOperation **operation)
+{
+    if (operation == NULL || *operation == NULL)
+    {
+        return AwaError_Unspecified;
+    }
+    free(*operation);
+    *operation = NULL;
+    return AwaError_Success;
+}
+
+AwaServerListClientsOperation *AwaServerListClientsOperation_New(const AwaServerSession *session)
+{
+    return calloc(1, sizeof(AwaServerListClientsOperation));
+}
+
+AwaError AwaServerListClientsOperation_Perform(AwaServerListClientsOperation *operation, AwaTimeout timeout)
+{
+    /* A poll made while recovering from a lapse is counted with the recovery */
+    if (g_soak.allocCount != NULL && !g_soak.polling && !IsRecovering())
+    {
+        g_soak.pollStart = AllocationsNow();
+        g_soak.polling = true;
+    }
+    operation->registered = IsRegistered();
+    return AwaError_Success;
+}
+
+AwaClientIterator *AwaServerListClientsOperation_NewClientIterator(const AwaServerListClientsOperation *operation)
+{
+    AwaClientIterator *iterator = calloc(1, sizeof(AwaClientIterator));
+
+    if (iterator != NULL)
+    {
+        iterator->registered = operation->registered;
+        iterator->listed = true;
+    }
+    return iterator;
+}
+
+AwaError AwaServerListClientsOperation_Free(AwaServerListClientsOperation **operation)
+{
+    if (operation == NULL || *operation == NULL)
+    {
+        return AwaError_Unspecified;
+    }
+    free(*operation);
+    *operation = NULL;
+    return AwaError_Success;
+}
+
+bool AwaClientIterator_Next(AwaClientIterator *iterator)
+{
+    if (iterator->started || !iterator->registered)
+    {
+        return false;
+    }
+    iterator->started = true;
+    return true;
+}
+
+const char *AwaClientIterator_GetClientID(const AwaClientIterator *iterator)
+{
+    return SOAK_CLIENT_ID;
+}
+
+void AwaClientIterator_Free(AwaClientIterator **iterator)
+{
+    if (iterator != NULL && *iterator != NULL)
+    {
+        if ((*iterator)->listed && g_soak.polling)
+        {
+            g_soak.pollDone += AllocationsNow() - g_soak.pollStart;
+            g_soak.polling = false;
+        }
+        free(*iterator);
+        *iterator = NULL;
+    }
+}
+
+AwaServerObserveOperation *AwaServerObserveOperation_New(const AwaServerSession *session)
+{
+    return calloc(1, sizeof(AwaServerObserveOperation));
+}
+
+AwaServerObservation *AwaServerObservation_New(const char *clientID, const char *path, AwaServerObservationCallback callback, void *context)
+{
+    AwaServerObservation *observation = calloc(1, sizeof(AwaServerObservation));
+
+    if (observation != NULL)
+    {
+        snprintf(observation->clientID, sizeof(observation->clientID), "%s", clientID);
+        snprintf(observation->path, sizeof(observation->path), "%s", path);
+        observation->callback = callback;
+        observation->context = context;
+    }
+    return observation;
+}
+
+AwaError AwaServerObservation_Free(AwaServerObservation **observation)
+{
+    if (observation == NULL || *observation == NULL)
+    {
+        return AwaError_Unspecified;
+    }
+    if (g_soak.observation == *observation)
+    {
+        g_soak.observation = NULL;
+    }
+    free(*observation);
+    *observation = NULL;
+    return AwaError_Success;
+}
+
+AwaError AwaServerObserveOperation_AddObservation(AwaServerObserveOperation *operation, AwaServerObservation *observation)
+{
+    if (operation == NULL || observation == NULL)
+    {
+        return AwaError_Unspecified;
+    }
+    operation->observation = observation;
+    operation->cancel = false;
+    return AwaError_Success;
+}
+
+AwaError AwaServerObserveOperation_AddCancelObservation(AwaServerObserveOperation *operation, AwaServerObservation *observation)
+{
+    if (operation == NULL || observation == NULL)
+    {
+        return AwaError_Unspecified;
+    }
+    operation->observation = observation;
+    operation->cancel = true;
+    return AwaError_Success;
+}
+
+AwaError AwaServerObserveOperation_Perform(AwaServerObserveOperation *operation, AwaTimeout timeout)
+{
+    if (operation == NULL || operation->observation == NULL)
+    {
+        return AwaError_Unspecified;
+    }
+
+    if (operation->cancel)
+    {
+        if (g_soak.observation == operation->observation)
+        {
+            g_soak.observation = NULL;
+        }
+    }
+    else if (strcmp(operation->observation->clientID, SOAK_CLIENT_ID) == 0 && IsRegistered() &&
+             AwaServerSession_IsObjectDefined(NULL, ObjectFromPath(operation->observation->path)))
+    {
+        g_soak.observation = operation->observation;
+        SetRecovery(&g_soak.reconnecting, false);
+        if (g_soak.awaitingReobserve)
+        {
+            uint64_t now = Clock_NowNs();
+            uint64_t latency = (now > g_soak.deregisteredUntilNs) ? now - g_soak.deregisteredUntilNs : 0;
+
+            SetRecovery(&g_soak.awaitingReobserve, false);
+            g_soak.interval.reobservations++;
+            if (latency > g_soak.interval.reobserveMaxNs)
+            {
+                g_soak.interval.reobserveMaxNs = latency;
+            }
+        }
+    }
+    else
+    {
+        return AwaError_Unspecified;
+    }
+    return AwaError_Success;
+}
+
+const AwaServerObserveResponse *AwaServerObserveOperation_GetResponse(const AwaServerObserveOperation *operation, const char *clientID)
+{
+    return &g_observeResponse;
+}
+
+AwaError AwaServerObserveOperation_Free(AwaServerObserveOperation **operation)
+{
+    if (operation == NULL || *operation == NULL)
+    {
+        return AwaError_Unspecified;
+    }
+    free(*operation);
+    *operation = NULL;
+    return AwaError_Success;
+}
+
+const AwaPathResult *AwaServerObserveResponse_GetPathResult(const AwaServerObserveResponse *response, const char *path)
+{
+    return &g_pathResult;
+}
+
+AwaError AwaPathResult_GetError(const AwaPathResult *result)
+{
+    return result->error;
+}
+
+const AwaServerSession *AwaChangeSet_GetServerSession(const AwaChangeSet *changeSet)
+{
+    return changeSet->session;
+}
+
+AwaError AwaChangeSet_GetValueAsIntegerPointer(const AwaChangeSet *changeSet, const char *path, const AwaInteger **value)
+{
+    if (g_soak.observation == NULL || strcmp(path, g_soak.observation->path) != 0)
+    {
+        return AwaError_Unspecified;
+    }
+    *value = &changeSet->value;
+    return AwaError_Success;
+}
@@ -0,0 +1,82 @@
+#!/bin/sh
+
+# Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+# and/or licensors
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without modification, are permitted
+# provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+#    and the following disclaimer.
+#
+# 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+#    conditions and the following disclaimer in the documentation and/or other materials provided
+#    with the distribution.
+#
+# 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+#    endorse or promote products derived from this software without specific prior written
+#    permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+# FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+# WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Soak the controller against a fake /sys/class/leds tree and the in-process Awa stand-in.
+#
+#   run_soak.sh <motion_led_controller_soak binary> [duration in seconds] [logread binary]
+#
+# Fault rates are taken from MLC_FAULTS, see src/fault.h; set MLC_FAULTS= to soak without faults.
+# Other knobs (MLC_SOAK_INTERVAL_MS, MLC_SOAK_REPORT_S, ...) are described in src/soak/fake_awa.c.
+# Heap allocations are counted if libmotion_led_controller_alloccount.so sits next to the binary.
+# Exits non zero if the stand-in's verdict is FAIL.
+
+BINARY=$1
+DURATION=${2:-60}
+LOGREAD=$3
+
+if [ ! -x "$BINARY" ]; then
+    echo "usage: $0 <motion_led_controller_soak> [duration_s] [motion_led_controller_logread]"
+    exit 2
+fi
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+# The sensor led dims through 256 brightness levels so that fades are exercised, the heartbeat
+# led is on/off like the gpio leds of the board.
+for LED_INDEX in 1 2
+do
+    LED_DIR="$WORKDIR/leds/marduk:red:user$LED_INDEX"
+    mkdir -p "$LED_DIR"
+    echo 0 > "$LED_DIR/brightness"
+done
+echo 255 > "$WORKDIR/leds/marduk:red:user1/max_brightness"
+echo 1 > "$WORKDIR/leds/marduk:red:user2/max_brightness"
+
+export MLC_SOAK_LED="$WORKDIR/leds/marduk:red:user1/brightness"
+export MLC_SOAK_DURATION_S=$DURATION
+export MLC_FAULTS=${MLC_FAULTS-"led_fail=0.01,led_slow=0.01,slow_ms=200,drop=0.01,ipc=0.002,ipc_burst=5,deregister=0.001"}
+
+ALLOC_COUNT="$(dirname "$BINARY")/libmotion_led_controller_alloccount.so"
+if [ -f "$ALLOC_COUNT" ]; then
+    PRELOAD="$ALLOC_COUNT"
+fi
+
+echo "Soaking for ${DURATION}s with faults '$MLC_FAULTS'"
+LD_PRELOAD="$PRELOAD" "$BINARY" -l "$WORKDIR/log" -r "$WORKDIR/leds" 2> "$WORKDIR/report"
+cat "$WORKDIR/report"
+
+if ! grep -q "soak: verdict PASS" "$WORKDIR/report"; then
+    if [ -x "$LOGREAD" ]; then
+        echo "Controller log tail:"
+        "$LOGREAD" "$WORKDIR/log" | tail -n 50
+    fi
+    exit 1
+fi
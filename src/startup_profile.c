@@ -0,0 +1,129 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file startup_profile.c
+ * @brief Per-phase timing of the controller start up sequence.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+
+#include "clock.h"
+#include "log.h"
+#include "startup_profile.h"
+
+/***************************************************************************************************
+ * Typedef
+ **************************************************************************************************/
+
+/**
+ * A structure to contain timing of a single start up phase.
+ */
+typedef struct
+{
+    /*@{*/
+    const char *name; /**< phase name used in the report */
+    uint64_t beginNs; /**< monotonic time the phase began, 0 if never run */
+    uint64_t endNs; /**< monotonic time the phase ended, 0 if still running */
+    /*@}*/
+}PhaseTiming;
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/** Reference time of the start up sequence. */
+static uint64_t g_startNs;
+
+/** Timing of each start up phase, indexed by StartupPhase. */
+static PhaseTiming g_phases[StartupPhase_Max] =
+{
+    { "session",        0, 0 },
+    { "definition",     0, 0 },
+    { "discovery",      0, 0 },
+    { "discovery wait", 0, 0 },
+    { "observe",        0, 0 },
+};
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+void StartupProfile_Start(void)
+{
+    g_startNs = Clock_NowNs();
+}
+
+void StartupProfile_Begin(StartupPhase phase)
+{
+    if (phase < StartupPhase_Max)
+    {
+        g_phases[phase].beginNs = Clock_NowNs();
+        g_phases[phase].endNs = 0;
+    }
+}
+
+void StartupProfile_End(StartupPhase phase)
+{
+    if (phase < StartupPhase_Max)
+    {
+        g_phases[phase].endNs = Clock_NowNs();
+    }
+}
+
+void StartupProfile_Report(void)
+{
+    unsigned int i;
+    uint64_t now = Clock_NowNs();
+
+    LOG(LOG_INFO, "Startup report (ms):");
+    for (i = 0; i < StartupPhase_Max; i++)
+    {
+        PhaseTiming *timing = &g_phases[i];
+
+        if (timing->beginNs == 0)
+        {
+            LOG(LOG_INFO, "  %-14s skipped", timing->name);
+            continue;
+        }
+
+        uint64_t end = (timing->endNs != 0) ? timing->endNs : now;
+        LOG(LOG_INFO, "  %-14s start +%-6llu took %llu%s",
+                timing->name,
+                (unsigned long long)((timing->beginNs - g_startNs) / NSEC_PER_MSEC),
+                (unsigned long long)((end - timing->beginNs) / NSEC_PER_MSEC),
+                (timing->endNs != 0) ? "" : " (unfinished)");
+    }
+    LOG(LOG_INFO, "  %-14s %llu", "total", (unsigned long long)((now - g_startNs) / NSEC_PER_MSEC));
+}
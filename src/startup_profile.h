@@ -0,0 +1,76 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file startup_profile.h
+ * @brief Per-phase timing of the controller start up sequence.
+ */
+
+#ifndef STARTUP_PROFILE_H
+#define STARTUP_PROFILE_H
+
+/**
+ * Phases of the start up sequence. Discovery runs on its own thread and
+ * overlaps with session and definition phases.
+ */
+typedef enum
+{
+    StartupPhase_Session,       /**< connecting the server session */
+    StartupPhase_Definition,    /**< defining objects on the server */
+    StartupPhase_Discovery,     /**< polling for constrained device registration */
+    StartupPhase_DiscoveryWait, /**< main thread blocked on discovery */
+    StartupPhase_Observe,       /**< setting up observations */
+    StartupPhase_Max
+} StartupPhase;
+
+/**
+ * @brief Record the reference time all phase offsets are reported against.
+ */
+void StartupProfile_Start(void);
+
+/**
+ * @brief Mark the beginning of a phase.
+ * @param phase phase being started.
+ */
+void StartupProfile_Begin(StartupPhase phase);
+
+/**
+ * @brief Mark the end of a phase.
+ * @param phase phase being finished.
+ */
+void StartupProfile_End(StartupPhase phase);
+
+/**
+ * @brief Log the offset and duration of every phase that has run, plus the total start up time.
+ *        A phase that was begun but never ended is reported as unfinished, up to now.
+ */
+void StartupProfile_Report(void);
+
+#endif  /* STARTUP_PROFILE_H */
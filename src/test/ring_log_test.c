@@ -0,0 +1,326 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file ring_log_test.c
+ * @brief Checks the ring log: records in order across wrap-around, finding the oldest complete
+ *        record, appending across reopen and recovering a write cut short by a crash.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ring_log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define TEST_LOG_SIZE               (RING_LOG_MIN_SIZE)
+#define RECORD_SIZE                 (32)
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            g_failures++; \
+        } \
+    } while (0)
+//! @endcond
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/** Number of failed checks. */
+static int g_failures = 0;
+
+/** Path of the log file under test. */
+static char g_path[] = "/tmp/ring_log_testXXXXXX";
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Append numbered records.
+ * @param *log ring log to write to.
+ * @param first number of the first record.
+ * @param count number of records.
+ */
+static void WriteRecords(RingLog *log, unsigned int first, unsigned int count)
+{
+    char record[RECORD_SIZE];
+    unsigned int i;
+
+    for (i = first; i < first + count; i++)
+    {
+        /* Odd length, so records keep landing across the end of the data area */
+        int length = snprintf(record, sizeof(record), "record %06u.\n", i);
+        RingLog_Write(log, record, length);
+    }
+}
+
+/**
+ * @brief Copy the bytes between two positions out of the data area, unwrapping them.
+ * @param *log ring log to read.
+ * @param from position of the first byte.
+ * @param to position after the last byte.
+ * @return the bytes as a string, to be freed by the caller.
+ */
+static char *ReadRange(const RingLog *log, uint32_t from, uint32_t to)
+{
+    uint32_t size = log->header->size;
+    char *text = malloc(to - from + 1);
+    uint32_t i;
+
+    for (i = 0; i < to - from; i++)
+    {
+        text[i] = log->data[(from + i) & (size - 1)];
+    }
+    text[to - from] = '\0';
+    return text;
+}
+
+/**
+ * @brief Check that text holds consecutive complete records, from first to last.
+ * @param *text records.
+ * @param first number of the first record expected.
+ * @param last number of the last record expected.
+ */
+static void CheckRecords(const char *text, unsigned int first, unsigned int last)
+{
+    unsigned int expected = first;
+    unsigned int number;
+    int consumed;
+
+    while (*text != '\0')
+    {
+        consumed = 0;
+        if (sscanf(text, "record %06u.\n%n", &number, &consumed) != 1 || consumed == 0 || text[consumed - 1] != '\n' || number != expected)
+        {
+            fprintf(stderr, "unexpected record at \"%.15s\", expected %u\n", text, expected);
+            g_failures++;
+            return;
+        }
+        text += consumed;
+        expected++;
+    }
+    CHECK(expected == last + 1);
+}
+
+/**
+ * @brief Records written before the log wraps are all kept, starting at position 0.
+ */
+static void TestBeforeWrap(void)
+{
+    RingLog log;
+
+    unlink(g_path);
+    CHECK(RingLog_Open(&log, g_path, TEST_LOG_SIZE));
+    WriteRecords(&log, 0, 10);
+
+    CHECK(!log.header->wrapped);
+    CHECK(log.header->reserved == log.header->head);
+
+    char *text = ReadRange(&log, 0, log.header->head);
+    CheckRecords(text, 0, 9);
+    free(text);
+    RingLog_Close(&log);
+}
+
+/**
+ * @brief Once the log has wrapped, the oldest complete record follows the partly overwritten
+ *        one, and every record after it is intact and in order.
+ */
+static void TestWrapAround(void)
+{
+    RingLog log;
+    unsigned int count = 3 * TEST_LOG_SIZE / 15;
+    unsigned int number;
+
+    unlink(g_path);
+    CHECK(RingLog_Open(&log, g_path, TEST_LOG_SIZE));
+    WriteRecords(&log, 0, count);
+
+    uint32_t head = log.header->head;
+    uint32_t oldest = log.header->reserved - log.header->size;
+
+    CHECK(log.header->wrapped);
+    CHECK(head == count * 15);
+
+    uint32_t position = RingLog_OldestRecord(log.data, log.header->size, oldest, head);
+    CHECK(position > oldest && position - oldest <= 15);
+    CHECK(log.data[(position - 1) & (log.header->size - 1)] == '\n');
+
+    char *text = ReadRange(&log, position, head);
+    CHECK(sscanf(text, "record %06u.", &number) == 1);
+    CheckRecords(text, number, count - 1);
+    CHECK(head - position > log.header->size - 15);
+    free(text);
+    RingLog_Close(&log);
+}
+
+/**
+ * @brief The oldest record search gives up at the head when no record ends before it.
+ */
+static void TestOldestRecordWithoutNewline(void)
+{
+    char data[TEST_LOG_SIZE];
+
+    memset(data, 'x', sizeof(data));
+    CHECK(RingLog_OldestRecord(data, sizeof(data), 100, 200) == 200);
+
+    data[150] = '\n';
+    CHECK(RingLog_OldestRecord(data, sizeof(data), 100, 200) == 151);
+
+    /* Positions wrap modulo 2^32, and the search follows them across */
+    data[2] = '\n';
+    CHECK(RingLog_OldestRecord(data, sizeof(data), 0xfffffffeU, 10) == 3);
+}
+
+/**
+ * @brief Records longer than the log keep their last bytes.
+ */
+static void TestLongRecord(void)
+{
+    RingLog log;
+    char record[TEST_LOG_SIZE + 100];
+    unsigned int i;
+
+    for (i = 0; i < sizeof(record); i++)
+    {
+        record[i] = 'a' + i % 26;
+    }
+
+    unlink(g_path);
+    CHECK(RingLog_Open(&log, g_path, TEST_LOG_SIZE));
+    RingLog_Write(&log, record, sizeof(record));
+    CHECK(log.header->head == TEST_LOG_SIZE);
+
+    char *text = ReadRange(&log, 0, TEST_LOG_SIZE);
+    CHECK(memcmp(text, record + 100, TEST_LOG_SIZE) == 0);
+    free(text);
+    RingLog_Close(&log);
+}
+
+/**
+ * @brief Reopening appends to the log, and a size that is not a power of two is rounded up.
+ */
+static void TestReopen(void)
+{
+    RingLog log;
+
+    unlink(g_path);
+    CHECK(RingLog_Open(&log, g_path, TEST_LOG_SIZE + 1));
+    CHECK(log.header->size == 2 * TEST_LOG_SIZE);
+    WriteRecords(&log, 0, 5);
+    RingLog_Close(&log);
+
+    CHECK(RingLog_Open(&log, g_path, TEST_LOG_SIZE + 1));
+    WriteRecords(&log, 5, 5);
+    char *text = ReadRange(&log, 0, log.header->head);
+    CheckRecords(text, 0, 9);
+    free(text);
+    RingLog_Close(&log);
+
+    CHECK(!RingLog_Open(&log, g_path, TEST_LOG_SIZE - 1));
+}
+
+/**
+ * @brief A write cut short after its reservation is never read as a record, and reopening turns
+ *        whatever part of it landed into a blank line.
+ */
+static void TestInterruptedWrite(void)
+{
+    RingLog log;
+
+    unlink(g_path);
+    CHECK(RingLog_Open(&log, g_path, TEST_LOG_SIZE));
+    WriteRecords(&log, 0, 3);
+
+    /* As if the writer died half way through copying a record in */
+    uint32_t head = log.header->head;
+    log.header->reserved = head + 15;
+    memcpy(log.data + head, "record 00", 9);
+    CHECK(log.header->head == head);
+    RingLog_Close(&log);
+
+    CHECK(RingLog_Open(&log, g_path, TEST_LOG_SIZE));
+    CHECK(log.header->head == head + 15);
+    CHECK(log.header->reserved == log.header->head);
+    CHECK(memcmp(log.data + head, "              \n", 15) == 0);
+
+    WriteRecords(&log, 3, 1);
+    char *text = ReadRange(&log, head + 15, log.header->head);
+    CheckRecords(text, 3, 3);
+    free(text);
+    RingLog_Close(&log);
+}
+
+/**
+ * @brief Run all ring log checks.
+ */
+int main(void)
+{
+    int fd = mkstemp(g_path);
+
+    if (fd < 0)
+    {
+        perror("mkstemp");
+        return EXIT_FAILURE;
+    }
+    close(fd);
+
+    TestBeforeWrap();
+    TestWrapAround();
+    TestOldestRecordWithoutNewline();
+    TestLongRecord();
+    TestReopen();
+    TestInterruptedWrite();
+
+    unlink(g_path);
+    if (g_failures != 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return EXIT_FAILURE;
+    }
+    printf("All ring log checks passed\n");
+    return EXIT_SUCCESS;
+}
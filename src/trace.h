@@ -0,0 +1,68 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file trace.h
+ * @brief Static user space tracepoints (USDT) for perf and bpftrace. Probes are compiled in only
+ *        when ENABLE_USDT is defined, and are a single nop each when not being traced.
+ *
+ * Probes are registered under the "motion_led_controller" provider. Timestamps are CLOCK_MONOTONIC
+ * nanoseconds, the same clock as bpftrace's nsecs, so stages can be correlated across probes.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifdef ENABLE_USDT
+
+#include <sys/sdt.h>
+
+//! \{
+#define TRACE(name)                         DTRACE_PROBE(motion_led_controller, name)
+#define TRACE1(name, a)                     DTRACE_PROBE1(motion_led_controller, name, a)
+#define TRACE2(name, a, b)                  DTRACE_PROBE2(motion_led_controller, name, a, b)
+#define TRACE3(name, a, b, c)               DTRACE_PROBE3(motion_led_controller, name, a, b, c)
+#define TRACE4(name, a, b, c, d)            DTRACE_PROBE4(motion_led_controller, name, a, b, c, d)
+//! \}
+
+#else
+
+/* Arguments are cast to void so that values computed only for tracing do not warn */
+//! \{
+#define TRACE(name)                         do {} while (0)
+#define TRACE1(name, a)                     do { (void)(a); } while (0)
+#define TRACE2(name, a, b)                  do { (void)(a); (void)(b); } while (0)
+#define TRACE3(name, a, b, c)               do { (void)(a); (void)(b); (void)(c); } while (0)
+#define TRACE4(name, a, b, c, d)            do { (void)(a); (void)(b); (void)(c); (void)(d); } while (0)
+//! \}
+
+#endif
+
+#endif  /* TRACE_H */
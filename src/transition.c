@@ -0,0 +1,319 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file transition.c
+ * @brief Brightness transitions of many leds driven from a single fixed rate frame timer.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include "clock.h"
+#include "log.h"
+#include "trace.h"
+#include "transition.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define GAMMA_MAX                   (65535ULL)
+#define LEVELS                      (TRANSITION_LEVEL_MAX + 1)
+//! @endcond
+
+/*
+ * Lookup tables are expanded by the preprocessor from integer constant expressions, so they are
+ * generated at compile time without a host tool, which would not survive cross compilation.
+ */
+//! @cond Doxygen_Suppress
+#define REPEAT4(m, n)               m(n) m((n) + 1) m((n) + 2) m((n) + 3)
+#define REPEAT16(m, n)              REPEAT4(m, n) REPEAT4(m, (n) + 4) REPEAT4(m, (n) + 8) REPEAT4(m, (n) + 12)
+#define REPEAT64(m, n)              REPEAT16(m, n) REPEAT16(m, (n) + 16) REPEAT16(m, (n) + 32) REPEAT16(m, (n) + 48)
+#define REPEAT256(m)                REPEAT64(m, 0) REPEAT64(m, 64) REPEAT64(m, 128) REPEAT64(m, 192)
+//! @endcond
+
+/**
+ * Smoothstep easing, 3x^2 - 2x^3 with x = i / 255, scaled to 0..255 and rounded.
+ */
+#define EASE_ENTRY(i) \
+    (uint8_t)(((uint64_t)(i) * (i) * (3 * 255 - 2 * (i)) + 255 * 255 / 2) / (255 * 255)),
+
+/**
+ * CIE 1931 lightness to luminance, L = i * 100 / 255, scaled to 0..GAMMA_MAX and rounded.
+ * Luminance is L / 903.3 up to L = 8 and ((L + 16) / 116)^3 above, evaluated with both
+ * numerator and denominator multiplied by 255 so that everything stays integral.
+ */
+#define GAMMA_CUBE(x)               ((uint64_t)(x) * (x) * (x))
+#define GAMMA_ENTRY(i) \
+    (uint16_t)(((i) * 100 <= 8 * 255) ? \
+        ((uint64_t)(i) * 100 * 10 * GAMMA_MAX + 255 * 9033 / 2) / (255 * 9033) : \
+        (GAMMA_CUBE((i) * 100 + 16 * 255) * GAMMA_MAX + GAMMA_CUBE(116 * 255) / 2) / GAMMA_CUBE(116 * 255)),
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/** Eased progress indexed by linear progress, both 0..255. */
+static const uint8_t g_easing[LEVELS] = { REPEAT256(EASE_ENTRY) };
+
+/** Luminance 0..GAMMA_MAX indexed by perceptual level. */
+static const uint16_t g_gamma[LEVELS] = { REPEAT256(GAMMA_ENTRY) };
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Get the level of an output at a given time.
+ * @param *output transition output.
+ * @param now current monotonic time.
+ * @return perceptual level.
+ */
+static uint8_t CurrentLevel(const TransitionOutput *output, uint64_t now)
+{
+    uint64_t elapsed;
+
+    if (!output->animating || now >= output->startNs + output->durationNs)
+    {
+        return output->to;
+    }
+
+    elapsed = (now > output->startNs) ? now - output->startNs : 0;
+    unsigned int progress = g_easing[elapsed * TRANSITION_LEVEL_MAX / output->durationNs];
+    return (uint8_t)((int)output->from + ((int)output->to - (int)output->from) * (int)progress / TRANSITION_LEVEL_MAX);
+}
+
+/**
+ * @brief Map a perceptual level to led brightness. Rounded up, so a led with few brightness
+ *        levels lights as soon as a fade starts and goes dark only when it ends.
+ * @param level perceptual level.
+ * @param maxBrightness largest brightness the led accepts.
+ * @return brightness to write.
+ */
+static unsigned int Quantize(uint8_t level, unsigned int maxBrightness)
+{
+    return (unsigned int)(((uint64_t)g_gamma[level] * maxBrightness + GAMMA_MAX - 1) / GAMMA_MAX);
+}
+
+/**
+ * @brief Write an output's brightness if it differs from what the led already shows.
+ * @param *output transition output.
+ * @param level perceptual level.
+ */
+static void Render(TransitionOutput *output, uint8_t level)
+{
+    unsigned int brightness = Quantize(level, output->led->maxBrightness);
+    int result;
+
+    if (brightness == output->written)
+    {
+        return;
+    }
+
+    TRACE2(led_write_entry, output->led->index, brightness);
+    result = Led_Set(output->led, brightness);
+    TRACE3(led_write_exit, output->led->index, brightness, result);
+
+    if (result != 0)
+    {
+        /* Leave written stale so that the next frame retries */
+        LOG(LOG_WARN, "Setting led failed.");
+        return;
+    }
+    output->written = brightness;
+}
+
+void Transition_Init(TransitionEngine *engine, TransitionOutput *outputs, Led **leds, unsigned int numOutputs,
+    unsigned int frameRate, TransitionReleaseCallback onRelease)
+{
+    unsigned int i;
+
+    engine->outputs = outputs;
+    engine->numOutputs = numOutputs;
+    engine->framePeriodNs = NSEC_PER_SEC / (frameRate ? frameRate : 1);
+    engine->nextFrameNs = 0;
+    engine->onRelease = onRelease;
+
+    for (i = 0; i < numOutputs; i++)
+    {
+        outputs[i].led = leds[i];
+        outputs[i].from = 0;
+        outputs[i].to = 0;
+        outputs[i].startNs = 0;
+        outputs[i].durationNs = 0;
+        outputs[i].animating = false;
+        outputs[i].releasePending = false;
+        outputs[i].written = 0;
+    }
+}
+
+/**
+ * @brief Check whether any output is animating.
+ * @param *engine transition engine.
+ * @return true if a frame is needed.
+ */
+static bool IsAnimating(const TransitionEngine *engine)
+{
+    unsigned int i;
+
+    for (i = 0; i < engine->numOutputs; i++)
+    {
+        if (engine->outputs[i].animating)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Begin a transition of one output from its current level.
+ * @param *engine transition engine.
+ * @param *output transition output.
+ * @param level target level.
+ * @param durationNs length of the transition.
+ * @param now current monotonic time.
+ */
+static void Begin(TransitionEngine *engine, TransitionOutput *output, uint8_t level, uint64_t durationNs, uint64_t now)
+{
+    /* An idle engine renders straight away instead of waiting for the frame timer to come round */
+    if (!IsAnimating(engine))
+    {
+        engine->nextFrameNs = now;
+    }
+
+    output->from = CurrentLevel(output, now);
+    output->to = level;
+    /* A led that is only on or off does not fade, rounding would stretch its hold by the fade out */
+    output->durationNs = (durationNs && output->led->maxBrightness > 1) ? durationNs : 1;
+    /* Start a frame in so the first frame already moves, e.g. a fade in from dark lights the led at once */
+    output->startNs = now - ((engine->framePeriodNs < output->durationNs) ? engine->framePeriodNs : output->durationNs);
+    output->animating = true;
+}
+
+void Transition_Start(TransitionEngine *engine, unsigned int output, uint8_t level, unsigned int durationMs, uint64_t now)
+{
+    if (output >= engine->numOutputs)
+    {
+        return;
+    }
+
+    engine->outputs[output].releasePending = false;
+    Begin(engine, &engine->outputs[output], level, (uint64_t)durationMs * NSEC_PER_MSEC, now);
+}
+
+void Transition_Release(TransitionEngine *engine, unsigned int output, uint64_t atNs, unsigned int durationMs)
+{
+    if (output >= engine->numOutputs)
+    {
+        return;
+    }
+
+    engine->outputs[output].releasePending = true;
+    engine->outputs[output].releaseAtNs = atNs;
+    engine->outputs[output].releaseDurationNs = (uint64_t)durationMs * NSEC_PER_MSEC;
+}
+
+void Transition_Frame(TransitionEngine *engine, uint64_t now)
+{
+    unsigned int i;
+
+    for (i = 0; i < engine->numOutputs; i++)
+    {
+        TransitionOutput *output = &engine->outputs[i];
+
+        if (output->releasePending && now >= output->releaseAtNs)
+        {
+            output->releasePending = false;
+            Begin(engine, output, 0, output->releaseDurationNs, now);
+            if (engine->onRelease != NULL)
+            {
+                engine->onRelease(i);
+            }
+        }
+    }
+
+    if (!IsAnimating(engine) || now < engine->nextFrameNs)
+    {
+        return;
+    }
+
+    for (i = 0; i < engine->numOutputs; i++)
+    {
+        TransitionOutput *output = &engine->outputs[i];
+
+        if (output->animating)
+        {
+            Render(output, CurrentLevel(output, now));
+            /* Failed writes are retried on later frames, unless the led could not be opened at all */
+            if (now >= output->startNs + output->durationNs &&
+                (output->written == Quantize(output->to, output->led->maxBrightness) || output->led->fd < 0))
+            {
+                output->animating = false;
+            }
+        }
+    }
+
+    /* Keep a fixed rate, but skip frames rather than bunch them up after a stall */
+    engine->nextFrameNs += engine->framePeriodNs;
+    if (engine->nextFrameNs <= now)
+    {
+        engine->nextFrameNs = now + engine->framePeriodNs;
+    }
+}
+
+unsigned int Transition_TimeoutMs(const TransitionEngine *engine, uint64_t now, unsigned int idleMs)
+{
+    unsigned int i;
+    uint64_t dueNs = now + (uint64_t)idleMs * NSEC_PER_MSEC;
+
+    if (IsAnimating(engine) && engine->nextFrameNs < dueNs)
+    {
+        dueNs = engine->nextFrameNs;
+    }
+
+    for (i = 0; i < engine->numOutputs; i++)
+    {
+        if (engine->outputs[i].releasePending && engine->outputs[i].releaseAtNs < dueNs)
+        {
+            dueNs = engine->outputs[i].releaseAtNs;
+        }
+    }
+
+    if (dueNs <= now)
+    {
+        return 0;
+    }
+    /* Round up, waking early would only spin */
+    return (unsigned int)((dueNs - now + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC);
+}
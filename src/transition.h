@@ -0,0 +1,137 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file transition.h
+ * @brief Brightness transitions of many leds driven from a single fixed rate frame timer.
+ *
+ * Levels are perceptual lightness from 0 to TRANSITION_LEVEL_MAX. Each frame, the level of every
+ * animating output is eased along its transition, mapped to led brightness through a gamma table
+ * and written only if the quantized brightness differs from what the led already shows.
+ */
+
+#ifndef TRANSITION_H
+#define TRANSITION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "led.h"
+
+/** Highest perceptual level. */
+#define TRANSITION_LEVEL_MAX (255)
+
+/**
+ * Called when an output starts its scheduled release.
+ */
+typedef void (*TransitionReleaseCallback)(unsigned int output);
+
+/**
+ * A structure to contain the state of one output.
+ */
+typedef struct
+{
+    /*@{*/
+    Led *led; /**< led driven by this output */
+    uint8_t from; /**< level at start of transition */
+    uint8_t to; /**< level at end of transition */
+    uint64_t startNs; /**< start of transition */
+    uint64_t durationNs; /**< length of transition */
+    bool animating; /**< transition still in progress */
+    bool releasePending; /**< a fade to off is scheduled */
+    uint64_t releaseAtNs; /**< start of scheduled fade to off */
+    uint64_t releaseDurationNs; /**< length of scheduled fade to off */
+    unsigned int written; /**< brightness last written to the led */
+    /*@}*/
+}TransitionOutput;
+
+/**
+ * A structure to contain the transition engine.
+ */
+typedef struct
+{
+    /*@{*/
+    TransitionOutput *outputs; /**< outputs driven by the engine */
+    unsigned int numOutputs; /**< number of outputs */
+    uint64_t framePeriodNs; /**< time between frames */
+    uint64_t nextFrameNs; /**< time of next frame */
+    TransitionReleaseCallback onRelease; /**< release notification, may be NULL */
+    /*@}*/
+}TransitionEngine;
+
+/**
+ * @brief Initialise the engine. Outputs start at level 0 with their leds assumed off.
+ * @param *engine engine to initialise.
+ * @param *outputs storage for the outputs.
+ * @param **leds led of each output.
+ * @param numOutputs number of outputs.
+ * @param frameRate frames per second.
+ * @param onRelease called when a scheduled release starts, may be NULL.
+ */
+void Transition_Init(TransitionEngine *engine, TransitionOutput *outputs, Led **leds, unsigned int numOutputs,
+    unsigned int frameRate, TransitionReleaseCallback onRelease);
+
+/**
+ * @brief Start a transition from the output's current level, which may itself be mid transition,
+ *        so that interrupting a fade never makes the led jump. Cancels any scheduled release.
+ * @param *engine transition engine.
+ * @param output output index.
+ * @param level target level.
+ * @param durationMs length of the transition.
+ * @param now current monotonic time in nanoseconds.
+ */
+void Transition_Start(TransitionEngine *engine, unsigned int output, uint8_t level, unsigned int durationMs, uint64_t now);
+
+/**
+ * @brief Schedule a fade to off.
+ * @param *engine transition engine.
+ * @param output output index.
+ * @param atNs monotonic time the fade starts.
+ * @param durationMs length of the fade.
+ */
+void Transition_Release(TransitionEngine *engine, unsigned int output, uint64_t atNs, unsigned int durationMs);
+
+/**
+ * @brief Render a frame if one is due.
+ * @param *engine transition engine.
+ * @param now current monotonic time in nanoseconds.
+ */
+void Transition_Frame(TransitionEngine *engine, uint64_t now);
+
+/**
+ * @brief Get how long the caller may block before the next frame or scheduled release is due.
+ * @param *engine transition engine.
+ * @param now current monotonic time in nanoseconds.
+ * @param idleMs value to return when nothing is due.
+ * @return time in milliseconds.
+ */
+unsigned int Transition_TimeoutMs(const TransitionEngine *engine, uint64_t now, unsigned int idleMs);
+
+#endif  /* TRANSITION_H */